@@ -4,6 +4,26 @@
 #include <memory>
 #include <vector>
 #include <algorithm>  // For sorting in BST
+#include <iterator>
+#include <cstddef>
+#include <cmath>
+#include <queue>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace_harness.h"
 
 using namespace std;
 
@@ -23,6 +43,81 @@ public:
 
     EVChargingStationTrie() : root(make_unique<TrieNode>()) {}
 
+    // Tear the Trie down with an explicit stack so long station names cannot
+    // overflow the call stack through nested unique_ptr destructors
+    ~EVChargingStationTrie() {
+        vector<unique_ptr<TrieNode>> pending;
+        pending.push_back(move(root));
+        while (!pending.empty()) {
+            unique_ptr<TrieNode> node = move(pending.back());
+            pending.pop_back();
+            for (auto& child : node->children) {
+                pending.push_back(move(child.second));
+            }
+        }
+    }
+
+    EVChargingStationTrie(const EVChargingStationTrie&) = delete;
+    EVChargingStationTrie& operator=(const EVChargingStationTrie&) = delete;
+
+    // Lazy cursor over the stations below a Trie node, in the same order
+    // suggestStations prints them. Holds one frame per level of the current
+    // path, so callers can stream matches without recursion or copying the
+    // whole result set. Invalidated by inserting into the Trie.
+    class StationCursor {
+    private:
+        struct Frame {
+            const TrieNode* node;
+            unordered_map<char, unique_ptr<TrieNode>>::const_iterator next;  // Next child to visit
+        };
+
+        vector<Frame> frames;
+        string path;  // Name of the station at the top frame
+
+        // Descend to the next end-of-word node in preorder
+        void advance() {
+            while (!frames.empty()) {
+                Frame& top = frames.back();
+                if (top.next != top.node->children.end()) {
+                    char c = top.next->first;
+                    const TrieNode* child = top.next->second.get();
+                    ++top.next;
+                    frames.push_back({child, child->children.begin()});
+                    path.push_back(c);
+                    if (child->isEndOfWord) return;
+                } else {
+                    frames.pop_back();
+                    if (!frames.empty()) path.pop_back();  // The start node's prefix stays
+                }
+            }
+        }
+
+    public:
+        StationCursor() {}
+
+        StationCursor(const TrieNode* start, const string& prefix) : path(prefix) {
+            if (!start) return;
+            frames.push_back({start, start->children.begin()});
+            if (!start->isEndOfWord) advance();
+        }
+
+        bool valid() const { return !frames.empty(); }
+        const string& name() const { return path; }
+        const string& location() const { return frames.back().node->location; }
+        void next() { advance(); }
+    };
+
+    // Cursor over every station whose name starts with prefix
+    StationCursor stationsWithPrefix(const string& prefix) const {
+        const TrieNode* node = root.get();
+        for (char c : prefix) {
+            auto it = node->children.find(c);
+            if (it == node->children.end()) return StationCursor();
+            node = it->second.get();
+        }
+        return StationCursor(node, prefix);
+    }
+
     // Insert a charging station name into the Trie
     void insert(const string& stationName, const string& location) {
         if (stationName.empty()) {
@@ -61,11 +156,8 @@ public:
 
     // Auto-suggest stations based on prefix
     void suggestStations(TrieNode* node, const string& prefix) const {
-        if (node->isEndOfWord) {
-            cout << prefix << " (Location: " << node->location << ")" << endl;  // Print the station name and location
-        }
-        for (auto& child : node->children) {
-            suggestStations(child.second.get(), prefix + child.first);  // Recurse with updated prefix
+        for (StationCursor cursor(node, prefix); cursor.valid(); cursor.next()) {
+            cout << cursor.name() << " (Location: " << cursor.location() << ")" << endl;  // Print the station name and location
         }
     }
 
@@ -86,6 +178,442 @@ public:
         }
         suggestStations(node, prefix);  // Suggest stations based on the prefix
     }
+
+    struct FuzzyMatch {
+        string stationName;
+        string location;
+        int distance;  // Levenshtein distance to the query
+    };
+
+    // Best k stations within maxDistance edits of query, closest first (ties
+    // by name). Walks the Trie depth-first with one Levenshtein DP row per
+    // level, so shared prefixes are scored once; a subtree is skipped as soon
+    // as its row minimum exceeds the bound, and the bound tightens to the
+    // current k-th best once k matches are held. A nonzero nodeBudget caps
+    // the Trie nodes visited, giving a hard latency limit at the cost of
+    // possibly missing matches.
+    vector<FuzzyMatch> fuzzySearch(const string& query, int maxDistance, int k, size_t nodeBudget = 0) const {
+        vector<FuzzyMatch> result;
+        if (k <= 0 || maxDistance < 0) return result;
+
+        const size_t width = query.size() + 1;
+        vector<int> rows(width);  // rows[d * width + j]: distance of path[0..d) to query[0..j)
+        for (size_t j = 0; j < width; j++) rows[j] = (int)j;
+
+        auto worse = [](const FuzzyMatch& a, const FuzzyMatch& b) {
+            return a.distance != b.distance ? a.distance < b.distance : a.stationName < b.stationName;
+        };
+        priority_queue<FuzzyMatch, vector<FuzzyMatch>, decltype(worse)> best(worse);
+        auto offer = [&](const string& name, const TrieNode* node, int distance) {
+            FuzzyMatch match{name, node->location, distance};
+            if ((int)best.size() < k) {
+                best.push(move(match));
+            } else if (worse(match, best.top())) {
+                best.pop();
+                best.push(move(match));
+            }
+        };
+        auto bound = [&]() { return (int)best.size() < k ? maxDistance : best.top().distance; };
+
+        struct Frame {
+            const TrieNode* node;
+            unordered_map<char, unique_ptr<TrieNode>>::const_iterator next;
+        };
+        vector<Frame> frames;
+        string path;
+        if (root->isEndOfWord && (int)query.size() <= maxDistance) offer("", root.get(), (int)query.size());
+        frames.push_back({root.get(), root->children.begin()});
+        size_t visited = 1;
+
+        while (!frames.empty()) {
+            Frame& top = frames.back();
+            if (top.next == top.node->children.end()) {
+                frames.pop_back();
+                if (!path.empty()) path.pop_back();
+                continue;
+            }
+            if (nodeBudget && visited >= nodeBudget) break;
+            visited++;
+
+            char c = top.next->first;
+            const TrieNode* child = top.next->second.get();
+            ++top.next;
+
+            size_t depth = frames.size();  // Row index of child
+            if (rows.size() < (depth + 1) * width) rows.resize((depth + 1) * width);
+            const int* above = &rows[(depth - 1) * width];
+            int* row = &rows[depth * width];
+            row[0] = (int)depth;
+            int rowMin = row[0];
+            for (size_t j = 1; j < width; j++) {
+                int substitute = above[j - 1] + (query[j - 1] != c);
+                row[j] = min({above[j] + 1, row[j - 1] + 1, substitute});
+                rowMin = min(rowMin, row[j]);
+            }
+
+            if (rowMin > bound()) continue;  // No extension of this path can match
+            path.push_back(c);
+            if (child->isEndOfWord && row[width - 1] <= bound()) offer(path, child, row[width - 1]);
+            frames.push_back({child, child->children.begin()});
+        }
+
+        result.resize(best.size());
+        for (size_t i = result.size(); i-- > 0; best.pop()) result[i] = best.top();
+        return result;
+    }
+};
+
+// Read-only, succinct form of EVChargingStationTrie for serving a published
+// directory. The trie shape is LOUDS-encoded: nodes are numbered in
+// breadth-first order and each contributes one 1 bit per child followed by a
+// 0, so the whole shape costs about two bits per node. Edge labels are one
+// byte per node (sorted per parent), and a terminal bit per node, ranked,
+// maps a station name to its ID, which indexes a packed location table.
+//
+// The image is a flat byte array with 8-byte aligned sections. It is written
+// once by publish() and then mmap'd read-only by open(); every lookup runs
+// directly on the mapped bytes.
+class FrozenStationDirectory {
+private:
+    static constexpr uint32_t kMagic = 0x44535645;  // "EVSD"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kZerosPerSample = 256;  // select0 sampling rate
+    static constexpr uint32_t kWordsPerRankBlock = 8;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nodeCount;
+        uint32_t stationCount;
+        uint64_t loudsOffset, loudsWords;        // uint64_t[loudsWords]
+        uint64_t selectOffset, selectCount;      // uint32_t positions of every 256th zero
+        uint64_t labelOffset;                    // uint8_t[nodeCount - 1], label of node i + 1
+        uint64_t terminalOffset, terminalWords;  // uint64_t[terminalWords]
+        uint64_t rankOffset;                     // uint32_t terminal ones before each rank block
+        uint64_t locationIndexOffset;            // uint32_t[stationCount + 1]
+        uint64_t locationDataOffset, locationDataSize;
+        uint64_t totalSize;
+    };
+
+    const uint8_t* image = nullptr;
+    size_t imageSize = 0;
+    void* mapping = nullptr;  // Owned mmap, if any
+    Header header{};
+    const uint64_t* louds = nullptr;
+    const uint32_t* zeroSamples = nullptr;
+    const uint8_t* labels = nullptr;
+    const uint64_t* terminal = nullptr;
+    const uint32_t* terminalRank = nullptr;
+    const uint32_t* locationIndex = nullptr;
+    const char* locationData = nullptr;
+
+    // Position of the k-th 0 bit (0-based) in the LOUDS bits
+    uint64_t select0(uint32_t k) const {
+        uint64_t pos = zeroSamples[k / kZerosPerSample];
+        uint32_t remaining = k % kZerosPerSample;
+        if (remaining == 0) return pos;
+        uint64_t word = pos >> 6;
+        uint64_t zeros = ~louds[word];
+        zeros = (pos & 63) == 63 ? 0 : zeros & (~0ULL << ((pos & 63) + 1));
+        while (true) {
+            uint32_t count = (uint32_t)__builtin_popcountll(zeros);
+            if (remaining <= count) {
+                for (uint32_t i = 1; i < remaining; i++) zeros &= zeros - 1;
+                return word * 64 + __builtin_ctzll(zeros);
+            }
+            remaining -= count;
+            zeros = ~louds[++word];
+        }
+    }
+
+    // Children of node are the consecutive IDs [first, last)
+    void childRange(uint32_t node, uint32_t& first, uint32_t& last) const {
+        uint64_t start = node == 0 ? 0 : select0(node - 1) + 1;
+        uint64_t end = select0(node);
+        first = (uint32_t)(start - node + 1);
+        last = first + (uint32_t)(end - start);
+    }
+
+    // Child of node along label c, or 0 if there is none (0 is the root, never a child)
+    uint32_t child(uint32_t node, unsigned char c) const {
+        uint32_t first, last;
+        childRange(node, first, last);
+        const uint8_t* begin = labels + first - 1;
+        const uint8_t* end = labels + last - 1;
+        const uint8_t* it = lower_bound(begin, end, c);
+        return it != end && *it == c ? first + (uint32_t)(it - begin) : 0;
+    }
+
+    bool isTerminal(uint32_t node) const { return (terminal[node >> 6] >> (node & 63)) & 1; }
+
+    // Station ID of a terminal node: terminal nodes before it in BFS order
+    uint32_t stationID(uint32_t node) const {
+        uint32_t word = node >> 6;
+        uint32_t rank = terminalRank[word / kWordsPerRankBlock];
+        for (uint32_t w = word - word % kWordsPerRankBlock; w < word; w++) {
+            rank += (uint32_t)__builtin_popcountll(terminal[w]);
+        }
+        return rank + (uint32_t)__builtin_popcountll(terminal[word] & ((1ULL << (node & 63)) - 1));
+    }
+
+    // Node reached by reading name from the root, or -1
+    long long walk(const string& name) const {
+        uint32_t node = 0;
+        for (char c : name) {
+            node = child(node, (unsigned char)c);
+            if (node == 0) return -1;
+        }
+        return node;
+    }
+
+    template <typename T>
+    static uint64_t appendSection(vector<uint8_t>& out, const T* data, size_t count) {
+        out.resize((out.size() + 7) & ~size_t(7));
+        uint64_t offset = out.size();
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+        return offset;
+    }
+
+    // Check the sections' contents in one linear pass, so that no lookup on
+    // an image that passes can read outside it: the LOUDS bits must describe
+    // a tree of nodeCount nodes with every child numbered after its parent,
+    // the select samples and terminal ranks must match the bits they
+    // summarize, each parent's labels must be strictly increasing, and the
+    // location index must be monotonic within the location data.
+    static bool contentsValid(const Header& h, const uint8_t* bytes) {
+        const uint64_t* bits = reinterpret_cast<const uint64_t*>(bytes + h.loudsOffset);
+        const uint32_t* samples = reinterpret_cast<const uint32_t*>(bytes + h.selectOffset);
+        const uint8_t* labelBytes = bytes + h.labelOffset;
+        uint64_t ones = 0, zeros = 0;
+        bool previousOne = false;
+        for (uint64_t pos = 0; pos < 2ULL * h.nodeCount - 1; pos++) {
+            // Node `zeros` starts its group here unless the last bit was one
+            // of its children; it must have been numbered as a child already
+            if (!previousOne && ones < zeros) return false;
+            if ((bits[pos >> 6] >> (pos & 63)) & 1) {
+                if (++ones >= h.nodeCount) return false;
+                if (previousOne && labelBytes[ones - 1] <= labelBytes[ones - 2]) return false;
+                previousOne = true;
+                continue;
+            }
+            if (zeros % kZerosPerSample == 0 && samples[zeros / kZerosPerSample] != pos) return false;
+            zeros++;
+            previousOne = false;
+        }
+        if (zeros != h.nodeCount) return false;
+
+        const uint64_t* terminalBits = reinterpret_cast<const uint64_t*>(bytes + h.terminalOffset);
+        const uint32_t* ranks = reinterpret_cast<const uint32_t*>(bytes + h.rankOffset);
+        uint64_t terminals = 0;
+        for (uint64_t w = 0; w < h.terminalWords; w++) {
+            if (w % kWordsPerRankBlock == 0 && ranks[w / kWordsPerRankBlock] != terminals) return false;
+            terminals += (uint64_t)__builtin_popcountll(terminalBits[w]);
+        }
+        if (h.nodeCount % 64 && terminalBits[h.terminalWords - 1] >> (h.nodeCount % 64)) return false;
+        if (terminals != h.stationCount) return false;
+
+        const uint32_t* index = reinterpret_cast<const uint32_t*>(bytes + h.locationIndexOffset);
+        for (uint64_t id = 0; id < h.stationCount; id++) {
+            if (index[id] > index[id + 1]) return false;
+        }
+        return index[h.stationCount] <= h.locationDataSize;
+    }
+
+    void release() {
+        if (mapping) munmap(mapping, imageSize);
+        mapping = nullptr;
+        image = nullptr;
+        imageSize = 0;
+    }
+
+public:
+    FrozenStationDirectory() {}
+    ~FrozenStationDirectory() { release(); }
+
+    FrozenStationDirectory(const FrozenStationDirectory&) = delete;
+    FrozenStationDirectory& operator=(const FrozenStationDirectory&) = delete;
+
+    // Serialize the Trie into a directory image
+    static vector<uint8_t> freeze(const EVChargingStationTrie& trie) {
+        vector<const TrieNode*> order{trie.root.get()};  // BFS order
+        vector<uint64_t> loudsBits;
+        vector<uint8_t> labelBytes;
+        vector<uint64_t> terminalBits;
+        vector<uint32_t> locationOffsets{0};
+        string locationBytes;
+        uint64_t bitCount = 0;
+        auto pushBit = [&](bool one) {
+            if (bitCount % 64 == 0) loudsBits.push_back(0);
+            if (one) loudsBits.back() |= 1ULL << (bitCount % 64);
+            bitCount++;
+        };
+
+        vector<pair<unsigned char, const TrieNode*>> children;
+        for (size_t i = 0; i < order.size(); i++) {
+            const TrieNode* node = order[i];
+            if (i % 64 == 0) terminalBits.push_back(0);
+            if (node->isEndOfWord) {
+                terminalBits.back() |= 1ULL << (i % 64);
+                locationBytes += node->location;
+                locationOffsets.push_back((uint32_t)locationBytes.size());
+            }
+
+            children.clear();
+            for (const auto& entry : node->children) children.push_back({(unsigned char)entry.first, entry.second.get()});
+            sort(children.begin(), children.end(),
+                 [](const pair<unsigned char, const TrieNode*>& a, const pair<unsigned char, const TrieNode*>& b) { return a.first < b.first; });
+            for (const auto& entry : children) {
+                pushBit(true);
+                labelBytes.push_back(entry.first);
+                order.push_back(entry.second);
+            }
+            pushBit(false);
+        }
+        if (bitCount % 64) loudsBits.back() |= ~0ULL << (bitCount % 64);  // Padding must not read as zeros
+
+        vector<uint32_t> samples;
+        for (uint64_t pos = 0, zeros = 0; pos < bitCount; pos++) {
+            if ((loudsBits[pos >> 6] >> (pos & 63)) & 1) continue;
+            if (zeros++ % kZerosPerSample == 0) samples.push_back((uint32_t)pos);
+        }
+        vector<uint32_t> ranks;
+        uint32_t ones = 0;
+        for (size_t w = 0; w < terminalBits.size(); w++) {
+            if (w % kWordsPerRankBlock == 0) ranks.push_back(ones);
+            ones += (uint32_t)__builtin_popcountll(terminalBits[w]);
+        }
+
+        Header h{};
+        h.magic = kMagic;
+        h.version = kVersion;
+        h.nodeCount = (uint32_t)order.size();
+        h.stationCount = (uint32_t)locationOffsets.size() - 1;
+        vector<uint8_t> out(sizeof(Header));
+        h.loudsOffset = appendSection(out, loudsBits.data(), loudsBits.size());
+        h.loudsWords = loudsBits.size();
+        h.selectOffset = appendSection(out, samples.data(), samples.size());
+        h.selectCount = samples.size();
+        h.labelOffset = appendSection(out, labelBytes.data(), labelBytes.size());
+        h.terminalOffset = appendSection(out, terminalBits.data(), terminalBits.size());
+        h.terminalWords = terminalBits.size();
+        h.rankOffset = appendSection(out, ranks.data(), ranks.size());
+        h.locationIndexOffset = appendSection(out, locationOffsets.data(), locationOffsets.size());
+        h.locationDataOffset = appendSection(out, locationBytes.data(), locationBytes.size());
+        h.locationDataSize = locationBytes.size();
+        h.totalSize = out.size();
+        memcpy(out.data(), &h, sizeof(Header));
+        return out;
+    }
+
+    // Freeze the Trie and write the image to a file
+    static bool publish(const EVChargingStationTrie& trie, const string& path) {
+        vector<uint8_t> bytes = freeze(trie);
+        ofstream file(path, ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), (streamsize)bytes.size());
+        return (bool)file;
+    }
+
+    // Serve from an image already in memory; the bytes must outlive this
+    // object and be 8-byte aligned. Returns false if they are not a valid
+    // image. Every section is checked once here (O(image size)) so lookups
+    // can trust it afterwards.
+    bool attach(const uint8_t* bytes, size_t size) {
+        release();
+        if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(bytes) % 8) return false;
+        Header h;
+        memcpy(&h, bytes, sizeof(Header));
+        if (h.magic != kMagic || h.version != kVersion || h.totalSize != size || h.nodeCount == 0) return false;
+        // Sections start 8-byte aligned, as appendSection writes them
+        auto fits = [&](uint64_t offset, uint64_t length) { return offset % 8 == 0 && offset <= size && length <= size - offset; };
+        if (h.loudsWords > size / 8 || !fits(h.loudsOffset, h.loudsWords * 8) || h.loudsWords * 64 < 2ULL * h.nodeCount - 1 ||
+            !fits(h.selectOffset, h.selectCount * 4) || h.selectCount != (h.nodeCount + kZerosPerSample - 1) / kZerosPerSample ||
+            !fits(h.labelOffset, h.nodeCount - 1) ||
+            !fits(h.terminalOffset, h.terminalWords * 8) || h.terminalWords != (h.nodeCount + 63) / 64 ||
+            !fits(h.rankOffset, (h.terminalWords + kWordsPerRankBlock - 1) / kWordsPerRankBlock * 4) ||
+            !fits(h.locationIndexOffset, (h.stationCount + 1ULL) * 4) ||
+            !fits(h.locationDataOffset, h.locationDataSize) || !contentsValid(h, bytes)) {
+            return false;
+        }
+        header = h;
+        image = bytes;
+        imageSize = size;
+        louds = reinterpret_cast<const uint64_t*>(bytes + h.loudsOffset);
+        zeroSamples = reinterpret_cast<const uint32_t*>(bytes + h.selectOffset);
+        labels = bytes + h.labelOffset;
+        terminal = reinterpret_cast<const uint64_t*>(bytes + h.terminalOffset);
+        terminalRank = reinterpret_cast<const uint32_t*>(bytes + h.rankOffset);
+        locationIndex = reinterpret_cast<const uint32_t*>(bytes + h.locationIndexOffset);
+        locationData = reinterpret_cast<const char*>(bytes + h.locationDataOffset);
+        return true;
+    }
+
+    // Memory-map a published image read-only
+    bool open(const string& path) {
+        release();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        if (!attach(static_cast<const uint8_t*>(mapped), (size_t)st.st_size)) {
+            munmap(mapped, (size_t)st.st_size);
+            return false;
+        }
+        mapping = mapped;
+        return true;
+    }
+
+    bool isOpen() const { return image != nullptr; }
+    size_t sizeInBytes() const { return imageSize; }
+    uint32_t stationCount() const { return header.stationCount; }
+
+    // Station ID of an exact name, or -1
+    long long find(const string& stationName) const {
+        if (!image) return -1;
+        long long node = walk(stationName);
+        return node >= 0 && isTerminal((uint32_t)node) ? (long long)stationID((uint32_t)node) : -1;
+    }
+
+    string_view location(uint32_t id) const {
+        return string_view(locationData + locationIndex[id], locationIndex[id + 1] - locationIndex[id]);
+    }
+
+    // Call visit(name, id) for every station starting with prefix, in name order
+    template <typename Visit>
+    void forEachWithPrefix(const string& prefix, Visit visit) const {
+        if (!image) return;
+        long long start = walk(prefix);
+        if (start < 0) return;
+
+        struct Frame {
+            uint32_t next, last;  // Remaining children
+        };
+        vector<Frame> frames;
+        string path = prefix;
+        auto enter = [&](uint32_t node) {
+            if (isTerminal(node)) visit(path, stationID(node));
+            Frame frame;
+            childRange(node, frame.next, frame.last);
+            frames.push_back(frame);
+        };
+        enter((uint32_t)start);
+        while (!frames.empty()) {
+            Frame& top = frames.back();
+            if (top.next == top.last) {
+                frames.pop_back();
+                if (!frames.empty()) path.pop_back();
+                continue;
+            }
+            uint32_t node = top.next++;
+            path.push_back((char)labels[node - 1]);
+            enter(node);
+        }
+    }
 };
 
 // Binary Search Tree (BST) to store and manage stations sorted by names
@@ -108,25 +636,126 @@ private:
     unique_ptr<Node> root;
 
     void insert(unique_ptr<Node>& node, const Station& station) {
-        if (!node) {
-            node = make_unique<Node>(station);
-            return;
+        unique_ptr<Node>* link = &node;
+        while (*link) {
+            if (station.stationName < (*link)->station.stationName)
+                link = &(*link)->left;
+            else if (station.stationName > (*link)->station.stationName)
+                link = &(*link)->right;
+            else
+                return;
         }
-
-        if (station.stationName < node->station.stationName)
-            insert(node->left, station);
-        else if (station.stationName > node->station.stationName)
-            insert(node->right, station);
+        *link = make_unique<Node>(station);
     }
 
     void inOrderTraversal(const unique_ptr<Node>& node) const {
-        if (!node) return;
-        inOrderTraversal(node->left);
-        cout << "Station: " << node->station.stationName << ", Location: " << node->station.location << endl;
-        inOrderTraversal(node->right);
+        for (const_iterator it(node.get(), nullptr), last; it != last; ++it) {
+            cout << "Station: " << it->stationName << ", Location: " << it->location << endl;
+        }
     }
 
 public:
+    // Forward iterator over stations sorted by name. Keeps the stack of
+    // pending ancestors instead of recursing; invalidated by inserts.
+    class const_iterator {
+    private:
+        vector<const Node*> stack;  // Top is the current station
+
+        void pushLeftSpine(const Node* node) {
+            while (node) {
+                stack.push_back(node);
+                node = node->left.get();
+            }
+        }
+
+        // Position at the first station in the subtree with name >= from,
+        // or at its first station when from is null
+        const_iterator(const Node* node, const string* from) {
+            if (!from) {
+                pushLeftSpine(node);
+                return;
+            }
+            while (node) {
+                if (node->station.stationName >= *from) {
+                    stack.push_back(node);
+                    node = node->left.get();
+                } else {
+                    node = node->right.get();
+                }
+            }
+        }
+
+        friend class EVChargingStationBST;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Station value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Station* pointer;
+        typedef const Station& reference;
+
+        const_iterator() {}
+
+        reference operator*() const { return stack.back()->station; }
+        pointer operator->() const { return &stack.back()->station; }
+
+        const_iterator& operator++() {
+            const Node* node = stack.back();
+            stack.pop_back();
+            pushLeftSpine(node->right.get());
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return (stack.empty() ? nullptr : stack.back()) == (other.stack.empty() ? nullptr : other.stack.back());
+        }
+
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    // Iterator pair usable in a range-based for loop
+    struct StationRange {
+        const_iterator first, last;
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+    };
+
+    EVChargingStationBST() {}
+
+    // Dismantle the tree with an explicit stack; a degenerate (sorted-input)
+    // tree would otherwise recurse once per station in the destructor
+    ~EVChargingStationBST() {
+        vector<unique_ptr<Node>> pending;
+        if (root) pending.push_back(move(root));
+        while (!pending.empty()) {
+            unique_ptr<Node> node = move(pending.back());
+            pending.pop_back();
+            if (node->left) pending.push_back(move(node->left));
+            if (node->right) pending.push_back(move(node->right));
+        }
+    }
+
+    EVChargingStationBST(const EVChargingStationBST&) = delete;
+    EVChargingStationBST& operator=(const EVChargingStationBST&) = delete;
+
+    const_iterator begin() const { return const_iterator(root.get(), nullptr); }
+    const_iterator end() const { return const_iterator(); }
+
+    // First station whose name is >= name
+    const_iterator lowerBound(const string& name) const { return const_iterator(root.get(), &name); }
+
+    // Stations with names in [from, to), sorted by name
+    StationRange range(const string& from, const string& to) const {
+        if (!(from < to)) return {end(), end()};
+        return {lowerBound(from), lowerBound(to)};
+    }
+
     void insert(const Station& station) {
         insert(root, station);
     }
@@ -137,6 +766,196 @@ public:
     }
 };
 
+// Spatial index for "nearest station" lookups. Stations carry planar map
+// coordinates in kilometres and are bucketed into a uniform grid of
+// cellSize x cellSize cells, so kNN and radius queries only visit the cells
+// around the query point. Each cell also counts its stations with free
+// chargers, letting availability-filtered searches skip fully busy cells.
+class StationLocator {
+public:
+    struct Match {
+        string stationName;
+        double distance;  // Kilometres from the query point
+        int freeChargers;
+    };
+
+private:
+    struct Site {
+        string stationName;
+        double x, y;
+        int freeChargers;
+    };
+
+    struct Cell {
+        vector<int> sites;  // Indices into sites
+        int freeSites = 0;  // Sites with at least one free charger
+    };
+
+    double cellSize;
+    vector<Site> sites;
+    unordered_map<string, int> siteIndex;
+    unordered_map<long long, Cell> cells;
+    int minCellX = INT_MAX, maxCellX = INT_MIN, minCellY = INT_MAX, maxCellY = INT_MIN;
+
+    int cellCoord(double v) const { return (int)floor(v / cellSize); }
+
+    static long long cellKey(int cx, int cy) {
+        return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+    }
+
+    void removeFromCell(int index) {
+        const Site& site = sites[index];
+        Cell& cell = cells[cellKey(cellCoord(site.x), cellCoord(site.y))];
+        cell.sites.erase(find(cell.sites.begin(), cell.sites.end(), index));
+        if (site.freeChargers > 0) cell.freeSites--;
+    }
+
+    void addToCell(int index) {
+        const Site& site = sites[index];
+        int cx = cellCoord(site.x), cy = cellCoord(site.y);
+        Cell& cell = cells[cellKey(cx, cy)];
+        cell.sites.push_back(index);
+        if (site.freeChargers > 0) cell.freeSites++;
+        minCellX = min(minCellX, cx);
+        maxCellX = max(maxCellX, cx);
+        minCellY = min(minCellY, cy);
+        maxCellY = max(maxCellY, cy);
+    }
+
+    // Call visit(cell) for each occupied cell on the square ring at Chebyshev
+    // distance ring around (cx, cy), clipped to the occupied bounding box
+    template <typename Visit>
+    void forEachCellOnRing(int cx, int cy, int ring, Visit visit) const {
+        auto visitCell = [&](long long gx, long long gy) {
+            if (gy < minCellY || gy > maxCellY) return;
+            auto it = cells.find(cellKey((int)gx, (int)gy));
+            if (it != cells.end()) visit(it->second);
+        };
+        long long loX = max<long long>((long long)cx - ring, minCellX), hiX = min<long long>((long long)cx + ring, maxCellX);
+        long long loY = max<long long>((long long)cy - ring, minCellY), hiY = min<long long>((long long)cy + ring, maxCellY);
+        for (long long gx = loX; gx <= hiX; gx++) {
+            if (gx == (long long)cx - ring || gx == (long long)cx + ring) {
+                for (long long gy = loY; gy <= hiY; gy++) visitCell(gx, gy);
+            } else {
+                visitCell(gx, (long long)cy - ring);
+                if (ring > 0) visitCell(gx, (long long)cy + ring);
+            }
+        }
+    }
+
+    // True once ring has moved past every occupied cell
+    bool ringBeyondGrid(int cx, int cy, int ring) const {
+        return cx - ring <= minCellX && cx + ring >= maxCellX &&
+               cy - ring <= minCellY && cy + ring >= maxCellY;
+    }
+
+public:
+    explicit StationLocator(double cellSizeKm = 1.0) : cellSize(cellSizeKm) {}
+
+    // Add a station or move an existing one, setting its free charger count
+    void upsert(const string& stationName, double x, double y, int freeChargers) {
+        auto it = siteIndex.find(stationName);
+        int index;
+        if (it == siteIndex.end()) {
+            index = (int)sites.size();
+            siteIndex[stationName] = index;
+            sites.push_back({stationName, x, y, freeChargers});
+        } else {
+            index = it->second;
+            removeFromCell(index);
+            sites[index].x = x;
+            sites[index].y = y;
+            sites[index].freeChargers = freeChargers;
+        }
+        addToCell(index);
+    }
+
+    // Change a station's free charger count; false if the station is unknown
+    bool setFreeChargers(const string& stationName, int freeChargers) {
+        auto it = siteIndex.find(stationName);
+        if (it == siteIndex.end()) return false;
+        Site& site = sites[it->second];
+        Cell& cell = cells[cellKey(cellCoord(site.x), cellCoord(site.y))];
+        cell.freeSites += (freeChargers > 0) - (site.freeChargers > 0);
+        site.freeChargers = freeChargers;
+        return true;
+    }
+
+    // Up to k stations closest to (x, y), nearest first. With onlyFree, only
+    // stations that have a free charger are considered.
+    vector<Match> nearest(double x, double y, int k, bool onlyFree) const {
+        vector<Match> result;
+        if (k <= 0 || sites.empty()) return result;
+
+        auto farther = [](const pair<double, int>& a, const pair<double, int>& b) { return a.first < b.first; };
+        priority_queue<pair<double, int>, vector<pair<double, int>>, decltype(farther)> best(farther);
+        int cx = cellCoord(x), cy = cellCoord(y);
+        // Rings closer than the occupied bounding box are empty
+        int firstRing = max({0, minCellX - cx, cx - maxCellX, minCellY - cy, cy - maxCellY});
+
+        for (int ring = firstRing;; ring++) {
+            forEachCellOnRing(cx, cy, ring, [&](const Cell& cell) {
+                if (onlyFree && cell.freeSites == 0) return;
+                for (int index : cell.sites) {
+                    const Site& site = sites[index];
+                    if (onlyFree && site.freeChargers <= 0) continue;
+                    double d = hypot(site.x - x, site.y - y);
+                    if ((int)best.size() < k) {
+                        best.push({d, index});
+                    } else if (d < best.top().first) {
+                        best.pop();
+                        best.push({d, index});
+                    }
+                }
+            });
+            // Every cell on a later ring is at least ring * cellSize away
+            if ((int)best.size() == k && best.top().first <= ring * cellSize) break;
+            if (ringBeyondGrid(cx, cy, ring)) break;
+        }
+
+        result.resize(best.size());
+        for (size_t i = result.size(); i-- > 0; best.pop()) {
+            const Site& site = sites[best.top().second];
+            result[i] = {site.stationName, best.top().first, site.freeChargers};
+        }
+        return result;
+    }
+
+    // All stations within radius km of (x, y), nearest first
+    vector<Match> withinRadius(double x, double y, double radius, bool onlyFree) const {
+        vector<Match> result;
+        if (radius < 0 || sites.empty()) return result;
+        int loX = max(cellCoord(x - radius), minCellX), hiX = min(cellCoord(x + radius), maxCellX);
+        int loY = max(cellCoord(y - radius), minCellY), hiY = min(cellCoord(y + radius), maxCellY);
+        for (int cx = loX; cx <= hiX; cx++) {
+            for (int cy = loY; cy <= hiY; cy++) {
+                auto it = cells.find(cellKey(cx, cy));
+                if (it == cells.end() || (onlyFree && it->second.freeSites == 0)) continue;
+                for (int index : it->second.sites) {
+                    const Site& site = sites[index];
+                    if (onlyFree && site.freeChargers <= 0) continue;
+                    double d = hypot(site.x - x, site.y - y);
+                    if (d <= radius) result.push_back({site.stationName, d, site.freeChargers});
+                }
+            }
+        }
+        sort(result.begin(), result.end(), [](const Match& a, const Match& b) { return a.distance < b.distance; });
+        return result;
+    }
+};
+
+// Print search results from the locator
+void displayMatches(const vector<StationLocator::Match>& matches) {
+    if (matches.empty()) {
+        cout << "No stations found.\n";
+        return;
+    }
+    for (const auto& match : matches) {
+        cout << "Station: " << match.stationName << ", Distance: " << match.distance
+             << " km, Free chargers: " << match.freeChargers << endl;
+    }
+}
+
 // Function to display the menu and handle user input
 void displayMenu() {
     cout << "\nMenu:\n";
@@ -146,15 +965,337 @@ void displayMenu() {
     cout << "4. Display all charging stations (sorted)\n";
     cout << "5. Update a charging station\n";
     cout << "6. Delete a charging station\n";
-    cout << "7. Exit\n";
+    cout << "7. Find nearest charging stations\n";
+    cout << "8. Find charging stations within radius\n";
+    cout << "9. Update free chargers at a station\n";
+    cout << "10. Fuzzy search for a charging station\n";
+    cout << "11. Publish read-only station directory\n";
+    cout << "12. Open published station directory\n";
+    cout << "13. Search published directory\n";
+    cout << "14. Suggest from published directory\n";
+    cout << "15. Exit\n";
     cout << "Enter your choice: ";
 }
 
-int main() {
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its whitespace-separated arguments ('#' starts a comment line),
+// so station names and locations in a trace contain no spaces. --generate
+// writes a random trace; --replay runs a trace through a naive reference
+// (ordered maps and linear scans) and through the real structures, times
+// each and reports the first answer that differs. The published directory
+// run answers only S and P (and applies I), re-freezing the Trie whenever
+// stations changed; its other ops are not compared.
+//
+//   I name location x y free   insert station (Trie, BST, locator)
+//   S name                     exact search (-> 0/1)
+//   P prefix                   stations with prefix (-> name=location ..., by name)
+//   G from to                  stations with names in [from, to), by name
+//   Z query maxEdits k         fuzzy search (-> name:edits ...)
+//   N x y k free               k nearest (free = 1: only with free chargers)
+//   W x y radius free          within radius (-> names, by name)
+//   C name free                set free chargers (-> 0/1)
+
+string matchNames(const vector<StationLocator::Match>& matches, bool byName) {
+    vector<string> names;
+    for (const auto& match : matches) names.push_back(match.stationName);
+    if (byName) sort(names.begin(), names.end());
+    return joinAnswer(names);
+}
+
+// Reference for the station structures: ordered maps, every query a scan
+class ReferenceDirectory {
+private:
+    struct Site {
+        double x, y;
+        int freeChargers;
+    };
+
+    map<string, string> locations;   // Latest location, as the Trie keeps it
+    map<string, Site> sites;
+
+    static int editDistance(const string& a, const string& b) {
+        vector<int> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); j++) row[j] = (int)j;
+        for (size_t i = 1; i <= a.size(); i++) {
+            int diagonal = row[0];
+            row[0] = (int)i;
+            for (size_t j = 1; j <= b.size(); j++) {
+                int above = row[j];
+                row[j] = min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    }
+
+    // Sites by distance from (x, y), optionally only those with free chargers
+    vector<pair<double, string>> sitesByDistance(double x, double y, bool onlyFree) const {
+        vector<pair<double, string>> result;
+        for (const auto& site : sites) {
+            if (onlyFree && site.second.freeChargers <= 0) continue;
+            result.push_back({hypot(site.second.x - x, site.second.y - y), site.first});
+        }
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+public:
+    string apply(const TraceOp& op) {
+        switch (op.op) {
+        case 'I':
+            locations[op.args.at(0)] = op.args.at(1);
+            sites[op.args[0]] = {stod(op.args.at(2)), stod(op.args.at(3)), stoi(op.args.at(4))};
+            return "";
+        case 'S':
+            return locations.count(op.args.at(0)) ? "1" : "0";
+        case 'P': {
+            vector<string> items;
+            for (const auto& entry : locations) {
+                if (entry.first.compare(0, op.args.at(0).size(), op.args[0]) == 0) {
+                    items.push_back(entry.first + "=" + entry.second);
+                }
+            }
+            return joinAnswer(items);
+        }
+        case 'G': {
+            vector<string> names;
+            for (const auto& entry : locations) {
+                if (entry.first >= op.args.at(0) && entry.first < op.args.at(1)) names.push_back(entry.first);
+            }
+            return joinAnswer(names);
+        }
+        case 'Z': {
+            int maxEdits = stoi(op.args.at(1));
+            size_t k = stoul(op.args.at(2));
+            vector<pair<int, string>> scored;
+            for (const auto& entry : locations) {
+                int distance = editDistance(entry.first, op.args[0]);
+                if (distance <= maxEdits) scored.push_back({distance, entry.first});
+            }
+            sort(scored.begin(), scored.end());
+            vector<string> items;
+            for (size_t i = 0; i < scored.size() && i < k; i++) {
+                items.push_back(scored[i].second + ":" + to_string(scored[i].first));
+            }
+            return joinAnswer(items);
+        }
+        case 'N': {
+            auto ranked = sitesByDistance(stod(op.args.at(0)), stod(op.args.at(1)), op.args.at(3) == "1");
+            vector<string> names;
+            for (size_t i = 0; i < ranked.size() && (long long)i < stoll(op.args.at(2)); i++) names.push_back(ranked[i].second);
+            return joinAnswer(names);
+        }
+        case 'W': {
+            auto ranked = sitesByDistance(stod(op.args.at(0)), stod(op.args.at(1)), op.args.at(3) == "1");
+            vector<string> names;
+            for (const auto& entry : ranked) {
+                if (entry.first <= stod(op.args.at(2))) names.push_back(entry.second);
+            }
+            sort(names.begin(), names.end());
+            return joinAnswer(names);
+        }
+        case 'C': {
+            auto it = sites.find(op.args.at(0));
+            if (it == sites.end()) return "0";
+            it->second.freeChargers = stoi(op.args.at(1));
+            return "1";
+        }
+        }
+        return "";
+    }
+};
+
+// The Trie, BST and locator kept together as main keeps them
+struct StationIndexes {
+    EVChargingStationTrie trie;
+    EVChargingStationBST bst;
+    StationLocator locator;
+
+    string apply(const TraceOp& op) {
+        switch (op.op) {
+        case 'I':
+            trie.insert(op.args.at(0), op.args.at(1));
+            bst.insert(Station(op.args[0], op.args[1]));
+            locator.upsert(op.args[0], stod(op.args.at(2)), stod(op.args.at(3)), stoi(op.args.at(4)));
+            return "";
+        case 'S':
+            return trie.search(op.args.at(0)) ? "1" : "0";
+        case 'P': {
+            vector<string> items;
+            for (auto cursor = trie.stationsWithPrefix(op.args.at(0)); cursor.valid(); cursor.next()) {
+                items.push_back(cursor.name() + "=" + cursor.location());
+            }
+            sort(items.begin(), items.end());
+            return joinAnswer(items);
+        }
+        case 'G': {
+            vector<string> names;
+            for (const Station& station : bst.range(op.args.at(0), op.args.at(1))) names.push_back(station.stationName);
+            return joinAnswer(names);
+        }
+        case 'Z': {
+            vector<string> items;
+            for (const auto& match : trie.fuzzySearch(op.args.at(0), stoi(op.args.at(1)), stoi(op.args.at(2)))) {
+                items.push_back(match.stationName + ":" + to_string(match.distance));
+            }
+            return joinAnswer(items);
+        }
+        case 'N':
+            return matchNames(locator.nearest(stod(op.args.at(0)), stod(op.args.at(1)), stoi(op.args.at(2)),
+                                              op.args.at(3) == "1"), false);
+        case 'W':
+            return matchNames(locator.withinRadius(stod(op.args.at(0)), stod(op.args.at(1)), stod(op.args.at(2)),
+                                                   op.args.at(3) == "1"), true);
+        case 'C':
+            return locator.setFreeChargers(op.args.at(0), stoi(op.args.at(1))) ? "1" : "0";
+        }
+        return "";
+    }
+};
+
+// Published directory: inserts go to a Trie, which is frozen again before
+// the first lookup after any change
+struct PublishedDirectory {
+    EVChargingStationTrie trie;
+    vector<uint8_t> image;
+    FrozenStationDirectory directory;
+    bool stale = true;
+
+    string apply(const TraceOp& op) {
+        if (op.op == 'I') {
+            trie.insert(op.args.at(0), op.args.at(1));
+            stale = true;
+            return "";
+        }
+        if (op.op != 'S' && op.op != 'P') return "";
+        if (stale) {
+            image = FrozenStationDirectory::freeze(trie);
+            directory.attach(image.data(), image.size());
+            stale = false;
+        }
+        if (op.op == 'S') return directory.find(op.args.at(0)) >= 0 ? "1" : "0";
+        vector<string> items;
+        directory.forEachWithPrefix(op.args.at(0), [&](const string& name, uint32_t id) {
+            items.push_back(name + "=" + string(directory.location(id)));
+        });
+        return joinAnswer(items);
+    }
+};
+
+// Write a random trace: a build phase of inserts, then queries mixed with
+// occasional inserts and charger updates. Names share prefixes so prefix
+// and fuzzy queries have work to do.
+bool generateStationTrace(const string& path, long long operations, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    out.precision(10);
+    mt19937 rng(seed);
+    uniform_real_distribution<double> coordinate(0, 100);
+    vector<string> names;
+    auto randomName = [&]() {
+        string name = "st";
+        for (int len = 3 + rng() % 6; len > 0; len--) name.push_back("abcdefgh"[rng() % 8]);
+        return name;
+    };
+    auto knownName = [&]() { return names.empty() ? randomName() : names[rng() % names.size()]; };
+    auto insert = [&]() {
+        names.push_back(randomName());
+        out << "I " << names.back() << " loc" << rng() % 1000 << " " << coordinate(rng) << " "
+            << coordinate(rng) << " " << rng() % 4 << "\n";
+    };
+
+    out << "# Station directory trace, seed " << seed << "\n";
+    long long buildOps = operations / 2;
+    for (long long i = 0; i < buildOps; i++) insert();
+    for (long long i = buildOps; i < operations; i++) {
+        unsigned kind = rng() % 500;
+        if (kind == 0) {
+            insert();
+        } else if (kind < 50) {
+            out << "C " << knownName() << " " << rng() % 4 << "\n";
+        } else if (kind < 130) {
+            out << "S " << (rng() % 2 ? knownName() : randomName()) << "\n";
+        } else if (kind < 210) {
+            out << "P " << knownName().substr(0, 4 + rng() % 3) << "\n";
+        } else if (kind < 270) {
+            string from = knownName(), to = from.substr(0, 5);
+            to.back()++;  // Up to the next 5-character prefix
+            out << "G " << from << " " << to << "\n";
+        } else if (kind < 330) {
+            string query = knownName();
+            query[rng() % query.size()] = "abcdefgh"[rng() % 8];
+            out << "Z " << query << " " << 1 + rng() % 2 << " " << 1 + rng() % 5 << "\n";
+        } else if (kind < 430) {
+            out << "N " << coordinate(rng) << " " << coordinate(rng) << " " << 1 + rng() % 8 << " " << rng() % 2 << "\n";
+        } else {
+            out << "W " << coordinate(rng) << " " << coordinate(rng) << " " << 1 + rng() % 5 << " " << rng() % 2 << "\n";
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and both station structures; returns
+// the exit code
+int replayStationTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    try {
+        vector<string> expected, answers;
+        ReferenceDirectory reference;
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return reference.apply(op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        {
+            StationIndexes indexes;
+            {
+                QuietOutput quiet;
+                seconds = runTrace(trace, answers, [&](const TraceOp& op) { return indexes.apply(op); });
+            }
+            matched = reportRun("Trie + BST + locator", trace, seconds, answers, &expected) && matched;
+        }
+        {
+            PublishedDirectory published;
+            {
+                QuietOutput quiet;
+                seconds = runTrace(trace, answers, [&](const TraceOp& op) { return published.apply(op); });
+            }
+            matched = reportRun("published directory", trace, seconds, answers, &expected, "GZNWC") && matched;
+        }
+        return matched ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> [seed]
+    //   --replay <trace>
+    if (argc >= 4 && string(argv[1]) == "--generate") {
+        if (!generateStationTrace(argv[2], atoll(argv[3]), argc >= 5 ? (unsigned)atoi(argv[4]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayStationTrace(argv[2]);
+    }
+
     EVChargingStationTrie trie;
     EVChargingStationBST bst;
+    StationLocator locator;
+    FrozenStationDirectory directory;
+    string path;
     string stationName, location, prefix;
-    int choice;
+    double x, y, radius;
+    int choice, count;
+    char onlyFree;
 
     do {
         displayMenu();
@@ -167,8 +1308,13 @@ int main() {
             getline(cin, stationName);
             cout << "Enter location: ";
             getline(cin, location);
+            cout << "Enter map coordinates in km (x y): ";
+            cin >> x >> y;
+            cout << "Enter number of free chargers: ";
+            cin >> count;
             trie.insert(stationName, location);
             bst.insert(Station(stationName, location));
+            locator.upsert(stationName, x, y, count);
             break;
 
         case 2:
@@ -213,13 +1359,107 @@ int main() {
             break;
 
         case 7:
+            cout << "Enter your map coordinates in km (x y): ";
+            cin >> x >> y;
+            cout << "Enter number of stations to find: ";
+            cin >> count;
+            cout << "Only stations with free chargers? (y/n): ";
+            cin >> onlyFree;
+            displayMatches(locator.nearest(x, y, count, onlyFree == 'y' || onlyFree == 'Y'));
+            break;
+
+        case 8:
+            cout << "Enter your map coordinates in km (x y): ";
+            cin >> x >> y;
+            cout << "Enter search radius in km: ";
+            cin >> radius;
+            cout << "Only stations with free chargers? (y/n): ";
+            cin >> onlyFree;
+            displayMatches(locator.withinRadius(x, y, radius, onlyFree == 'y' || onlyFree == 'Y'));
+            break;
+
+        case 9:
+            cout << "Enter station name: ";
+            cin.ignore();
+            getline(cin, stationName);
+            cout << "Enter number of free chargers: ";
+            cin >> count;
+            if (locator.setFreeChargers(stationName, count)) {
+                cout << "Station '" << stationName << "' now has " << count << " free chargers.\n";
+            } else {
+                cout << "Charging station '" << stationName << "' not found.\n";
+            }
+            break;
+
+        case 10: {
+            int maxEdits;
+            cout << "Enter charging station name (typos allowed): ";
+            cin.ignore();
+            getline(cin, stationName);
+            cout << "Enter maximum number of typos and number of results: ";
+            cin >> maxEdits >> count;
+            vector<EVChargingStationTrie::FuzzyMatch> matches = trie.fuzzySearch(stationName, maxEdits, count);
+            if (matches.empty()) {
+                cout << "No close matches found.\n";
+            }
+            for (const auto& match : matches) {
+                cout << match.stationName << " (Location: " << match.location
+                     << ", Edits: " << match.distance << ")" << endl;
+            }
+            break;
+        }
+
+        case 11:
+            cout << "Enter file to publish the directory to: ";
+            cin >> path;
+            if (FrozenStationDirectory::publish(trie, path)) {
+                cout << "Station directory published to '" << path << "'.\n";
+            } else {
+                cout << "Could not write '" << path << "'.\n";
+            }
+            break;
+
+        case 12:
+            cout << "Enter published directory file: ";
+            cin >> path;
+            if (directory.open(path)) {
+                cout << "Opened " << directory.stationCount() << " stations (" << directory.sizeInBytes() << " bytes).\n";
+            } else {
+                cout << "'" << path << "' is not a valid station directory.\n";
+            }
+            break;
+
+        case 13: {
+            cout << "Enter charging station name to search: ";
+            cin.ignore();
+            getline(cin, stationName);
+            long long id = directory.find(stationName);
+            if (id >= 0) {
+                cout << "Charging station '" << stationName << "' found (Location: " << directory.location((uint32_t)id) << ").\n";
+            } else {
+                cout << "Charging station '" << stationName << "' not found.\n";
+            }
+            break;
+        }
+
+        case 14:
+            cout << "Enter prefix for charging station suggestion: ";
+            cin.ignore();
+            getline(cin, prefix);
+            cout << "Suggested charging stations for prefix '" << prefix << "':\n";
+            directory.forEachWithPrefix(prefix, [&](const string& name, uint32_t id) {
+                cout << name << " (Location: " << directory.location(id) << ")" << endl;
+            });
+            break;
+
+        case 15:
             cout << "Exiting...\n";
             break;
 
         default:
             cout << "Invalid choice. Please try again.\n";
         }
-    } while (choice != 7);
+    } while (choice != 15);
 
     return 0;
 }
@@ -1,164 +1,2715 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <cmath>
 #include <string>
 #include <algorithm>
 #include <numeric>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <array>
+#include <utility>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <memory>
+#include <queue>
+#include <functional>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#include "segment_id_interner.h"
+#include "sparse_table.h"
+#include "trace_harness.h"
 
 using namespace std;
 
-class SparseTable {
-private:
-    vector<vector<int>> maxTable, minTable;
-    vector<int> logTable;
+// Vehicle counts stored in the narrowest of 8, 16 or 32 bits that holds every
+// value written so far. Writing a value that does not fit widens the whole
+// array once, so networks with mostly small counts use a quarter or half of
+// the memory of plain ints and range tables built over them shrink the same way.
+// Counts live in ChunkedArrays, so growing never moves them; widening copies
+// every count and needs the same exclusion as a range-table rebuild.
+class AdaptiveCountArray {
+public:
+    enum Width { kCount8, kCount16, kCount32 };
+
+private:
+    Width width = kCount8;
+    ChunkedArray<uint8_t> counts8;    // Only the array matching width holds data
+    ChunkedArray<uint16_t> counts16;
+    ChunkedArray<int32_t> counts32;
+
+    static Width widthFor(int value) {
+        if (value >= 0 && value <= numeric_limits<uint8_t>::max()) return kCount8;
+        if (value >= 0 && value <= numeric_limits<uint16_t>::max()) return kCount16;
+        return kCount32;
+    }
+
+    template <typename From, typename To>
+    static void moveWidened(ChunkedArray<From>& from, ChunkedArray<To>& to) {
+        to.resize(0);
+        from.forEachSpan(0, from.size(), [&to](const From* data, size_t length) { to.append(data, data + length); });
+        from.clear();
+    }
+
+    void widen(Width target) {
+        if (width == kCount8 && target == kCount16) {
+            moveWidened(counts8, counts16);
+        } else if (width == kCount8) {
+            moveWidened(counts8, counts32);
+        } else {
+            moveWidened(counts16, counts32);
+        }
+        width = target;
+    }
+
+public:
+    AdaptiveCountArray(size_t n = 0) { counts8.resize(n, 0); }
+
+    // Call visitor with the active typed array (ChunkedArray<uint8_t>, <uint16_t> or <int32_t>)
+    template <typename Visitor>
+    auto visit(Visitor visitor) const {
+        switch (width) {
+            case kCount8: return visitor(counts8);
+            case kCount16: return visitor(counts16);
+            default: return visitor(counts32);
+        }
+    }
+
+    template <typename Visitor>
+    auto visit(Visitor visitor) {
+        switch (width) {
+            case kCount8: return visitor(counts8);
+            case kCount16: return visitor(counts16);
+            default: return visitor(counts32);
+        }
+    }
+
+    int operator[](size_t i) const {
+        switch (width) {
+            case kCount8: return counts8[i];
+            case kCount16: return counts16[i];
+            default: return counts32[i];
+        }
+    }
+
+    void set(size_t i, int value) {
+        Width needed = widthFor(value);
+        if (needed > width) widen(needed);
+        switch (width) {
+            case kCount8: counts8[i] = static_cast<uint8_t>(value); break;
+            case kCount16: counts16[i] = static_cast<uint16_t>(value); break;
+            default: counts32[i] = value; break;
+        }
+    }
+
+    void resize(size_t n) {
+        visit([n](auto& counts) { counts.resize(n, 0); });
+    }
+
+    // Sum of counts in [begin, end)
+    long long sum(size_t begin, size_t end) const {
+        return visit([begin, end](const auto& counts) {
+            long long total = 0;
+            counts.forEachSpan(begin, end, [&total](const auto* data, size_t length) {
+                total = accumulate(data, data + length, total);
+            });
+            return total;
+        });
+    }
+
+    Width storageWidth() const { return width; }
+    size_t size() const { return visit([](const auto& counts) { return counts.size(); }); }
+};
+
+// Range query structures over counts of one storage width; only the one
+// selected by linearSpace is built
+template <typename Count>
+struct RangeTables {
+    MaxMinSparseTable<Count> sparseTable;
+    BlockSparseTable<Count> blockTable;
+
+    RangeTables(unsigned buildThreads) : sparseTable(buildThreads), blockTable(buildThreads) {}
+
+    void build(const ChunkedArray<Count>& counts, bool linearSpace) {
+        vector<Count> values = counts.copy(0, counts.size());
+        if (linearSpace) {
+            blockTable.build(values);
+        } else {
+            sparseTable.build(values);
+        }
+    }
+
+    // Extend tables built over counts[0, from) with counts[from, end)
+    void append(const ChunkedArray<Count>& counts, size_t from, bool linearSpace) {
+        vector<Count> added = counts.copy(from, counts.size());
+        if (linearSpace) {
+            blockTable.append(added);
+        } else {
+            sparseTable.append(added);
+        }
+    }
+
+    // Set position pos to value in place; returns the cells recomputed
+    size_t update(size_t pos, Count value, bool linearSpace) {
+        return linearSpace ? blockTable.update(pos, value) : sparseTable.update(pos, value);
+    }
+
+    // Cells a build over n positions computes, in the units update returns
+    static size_t buildCells(size_t n, bool linearSpace) {
+        return linearSpace ? BlockSparseTable<Count>::buildCells(n) : MaxMinSparseTable<Count>::buildCells(n);
+    }
+
+    void clear() {
+        sparseTable.clear();
+        blockTable.clear();
+    }
+
+    // Max or min (by lane) over 0-based [L, R]
+    int query(int L, int R, size_t lane, bool linearSpace) const {
+        return linearSpace ? blockTable.query(L, R, lane) : sparseTable.query(L, R, lane);
+    }
+
+    // Answer many 0-based ranges, prefetching a few queries ahead
+    void queryBatch(const vector<pair<int, int>>& ranges, vector<int>& results, size_t lane, bool linearSpace) const {
+        if (linearSpace) {
+            blockTable.queryBatch(ranges, results, lane);
+        } else {
+            sparseTable.queryBatch(ranges, results, lane);
+        }
+    }
+};
+
+// Stable 64-bit hash (FNV-1a then a splitmix64 finalizer), so sketches built
+// by different threads or processes can be merged
+inline uint64_t sketchHash(const string& key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) h = (h ^ c) * 1099511628211ULL;
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+// Count-Min sketch of per-key maxima: kDepth rows of kWidth counters, each
+// keeping the largest value hashed to it. estimate() is never below the
+// largest value raised for a key, and is above it only when a larger key
+// collides with it in every row.
+class CountMinSketch {
+private:
+    static const int kDepth = 4;
+    static const int kWidth = 2048;
+    vector<uint32_t> counters;
+
+    static size_t column(uint64_t hash, int row) {
+        // Derive the row hashes from two halves of one 64-bit hash
+        uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32);
+        return (h1 + (uint32_t)row * h2) % kWidth;
+    }
+
+public:
+    CountMinSketch() : counters(kDepth * kWidth, 0) {}
+
+    void raise(uint64_t hash, uint32_t value) {
+        for (int row = 0; row < kDepth; row++) {
+            uint32_t& counter = counters[row * kWidth + column(hash, row)];
+            counter = max(counter, value);
+        }
+    }
+
+    uint32_t estimate(uint64_t hash) const {
+        uint32_t best = numeric_limits<uint32_t>::max();
+        for (int row = 0; row < kDepth; row++) best = min(best, counters[row * kWidth + column(hash, row)]);
+        return best;
+    }
+
+    void merge(const CountMinSketch& other) {
+        for (size_t i = 0; i < counters.size(); i++) counters[i] = max(counters[i], other.counters[i]);
+    }
+};
+
+// The `capacity` keys with the largest values raised for them, each with
+// that value exactly. A key is evicted only when `capacity` others are
+// larger, and it can never be among them again until it is raised past
+// them, so whatever is kept is exact. The entries form an indexed min-heap,
+// so an update is O(log capacity).
+class PeakTopK {
+public:
+    struct Entry {
+        string key;
+        uint32_t peak;
+    };
+
+private:
+    size_t capacity;
+    vector<Entry> heap;                    // Min-heap on peak
+    unordered_map<string, size_t> slot;    // Key -> index in heap
+
+    void swapEntries(size_t a, size_t b) {
+        swap(heap[a], heap[b]);
+        slot[heap[a].key] = a;
+        slot[heap[b].key] = b;
+    }
+
+    void siftDown(size_t i) {
+        while (true) {
+            size_t smallest = i, left = 2 * i + 1, right = left + 1;
+            if (left < heap.size() && heap[left].peak < heap[smallest].peak) smallest = left;
+            if (right < heap.size() && heap[right].peak < heap[smallest].peak) smallest = right;
+            if (smallest == i) return;
+            swapEntries(i, smallest);
+            i = smallest;
+        }
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0 && heap[i].peak < heap[(i - 1) / 2].peak) {
+            swapEntries(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+public:
+    explicit PeakTopK(size_t capacity) : capacity(max<size_t>(capacity, 1)) {}
+
+    void raise(const string& key, uint32_t value) {
+        auto it = slot.find(key);
+        if (it != slot.end()) {
+            if (value <= heap[it->second].peak) return;
+            heap[it->second].peak = value;
+            siftDown(it->second);   // Peaks only grow
+            return;
+        }
+        if (heap.size() < capacity) {
+            heap.push_back({key, value});
+            slot[key] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+            return;
+        }
+        if (value <= heap[0].peak) return;
+        slot.erase(heap[0].key);
+        heap[0] = {key, value};
+        slot[key] = 0;
+        siftDown(0);
+    }
+
+    // Exact peak of a kept key; false if the key is not kept
+    bool find(const string& key, uint32_t& peak) const {
+        auto it = slot.find(key);
+        if (it == slot.end()) return false;
+        peak = heap[it->second].peak;
+        return true;
+    }
+
+    // Upper bound on the peak of any key not kept: 0 while there is room
+    // (every key raised is kept), else the smallest kept peak
+    uint32_t floor() const { return heap.size() < capacity ? 0 : heap[0].peak; }
+
+    const vector<Entry>& entries() const { return heap; }
+
+    void merge(const PeakTopK& other) {
+        for (const Entry& entry : other.heap) raise(entry.key, entry.peak);
+    }
+};
+
+// HyperLogLog distinct counter with 2^12 one-byte registers (about 1.6%
+// standard error in 4 KB). Merging takes the register-wise maximum.
+class HyperLogLog {
+private:
+    static const int kPrecision = 12;
+    static const size_t kRegisters = size_t(1) << kPrecision;
+    vector<uint8_t> registers;
+
+public:
+    HyperLogLog() : registers(kRegisters, 0) {}
+
+    void add(uint64_t hash) {
+        size_t index = hash >> (64 - kPrecision);
+        uint64_t rest = hash << kPrecision;
+        uint8_t rank = rest == 0 ? 64 - kPrecision + 1 : (uint8_t)(__builtin_clzll(rest) + 1);
+        registers[index] = max(registers[index], rank);
+    }
+
+    double estimate() const {
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+        const double m = (double)kRegisters;
+        double raw = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0) return m * log(m / zeros);   // Linear counting for small sets
+        return raw;
+    }
+
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < kRegisters; i++) registers[i] = max(registers[i], other.registers[i]);
+    }
+};
+
+// Optional approximate analytics over a sliding window, fed from
+// TrafficMonitor updates. Time is cut into epochs (one minute by default)
+// and a ring keeps the sketches of the last windowEpochs of them (an hour);
+// recording into a new epoch reuses the slot of the one that just left the
+// window, and queries combine the epochs still inside it.
+//
+// A segment's volume is the sum over the window of its peak reported count
+// in each epoch, roughly vehicle-minutes: it counts once per epoch however
+// often it reports, so chatty segments do not look busier, but a segment
+// that goes quiet for an epoch contributes nothing to it. Vehicle sightings
+// go to one HyperLogLog per epoch. Memory is fixed by the window and sketch
+// sizes (about 2 MB for an hour), not the network size. Epochs are numbered
+// from the Unix epoch and keys are external IDs, so sketches from other
+// threads or nodes merge epoch by epoch.
+class TrafficSketches {
+public:
+    typedef chrono::system_clock Clock;
+
+    // A segment's estimated volume over the window. volume is never below
+    // the true value and exceeds it by at most error.
+    struct BusySegment {
+        string segmentID;
+        uint64_t volume;
+        uint64_t error;
+    };
+
+private:
+    struct Epoch {
+        long long index = -1;   // Epoch this slot holds; -1 while unused
+        CountMinSketch peaks;
+        PeakTopK busiest;
+        HyperLogLog vehicles;
+
+        explicit Epoch(size_t topCapacity) : busiest(topCapacity) {}
+    };
+
+    size_t topCapacity;
+    Clock::duration epochLength;
+    vector<Epoch> ring;   // Epoch e lives in ring[e % ring.size()]
+
+    long long epochOf(Clock::time_point time) const {
+        return time.time_since_epoch() / epochLength;
+    }
+
+    bool inWindow(const Epoch& epoch, long long now) const {
+        return epoch.index >= 0 && epoch.index <= now && now - epoch.index < (long long)ring.size();
+    }
+
+    // Slot for recording into epoch `index`, or nullptr if it already left the window
+    Epoch* slotFor(long long index) {
+        Epoch& epoch = ring[index % ring.size()];
+        if (epoch.index > index) return nullptr;
+        if (epoch.index < index) {
+            epoch = Epoch(topCapacity);
+            epoch.index = index;
+        }
+        return &epoch;
+    }
+
+    // Peak of one segment in one epoch: exact if kept by the epoch's top-K,
+    // else bounded by the top-K floor and the Count-Min estimate. Returns
+    // whether it is exact.
+    static bool epochPeak(const Epoch& epoch, const string& segmentID, uint64_t hash, uint32_t& peak) {
+        if (epoch.busiest.find(segmentID, peak)) return true;
+        peak = min(epoch.busiest.floor(), epoch.peaks.estimate(hash));
+        return peak == 0;
+    }
+
+    BusySegment windowVolume(const string& segmentID, long long now) const {
+        BusySegment result = {segmentID, 0, 0};
+        uint64_t hash = sketchHash(segmentID);
+        for (const Epoch& epoch : ring) {
+            if (!inWindow(epoch, now)) continue;
+            uint32_t peak;
+            bool exact = epochPeak(epoch, segmentID, hash, peak);
+            result.volume += peak;
+            if (!exact) result.error += peak;
+        }
+        return result;
+    }
+
+public:
+    explicit TrafficSketches(size_t topCapacity = 64, int windowEpochs = 60,
+                             Clock::duration epochLength = chrono::minutes(1))
+        : topCapacity(topCapacity), epochLength(epochLength), ring(max(windowEpochs, 1), Epoch(topCapacity)) {}
+
+    void recordTraffic(const string& segmentID, int vehicleCount, Clock::time_point time = Clock::now()) {
+        Epoch* epoch = slotFor(epochOf(time));
+        if (!epoch || vehicleCount <= 0) return;
+        epoch->peaks.raise(sketchHash(segmentID), (uint32_t)vehicleCount);
+        epoch->busiest.raise(segmentID, (uint32_t)vehicleCount);
+    }
+
+    void recordVehicle(const string& vehicleID, Clock::time_point time = Clock::now()) {
+        Epoch* epoch = slotFor(epochOf(time));
+        if (epoch) epoch->vehicles.add(sketchHash(vehicleID));
+    }
+
+    // Approximate volume of a segment over the window ending at time (never low)
+    uint64_t estimatedVolume(const string& segmentID, Clock::time_point time = Clock::now()) const {
+        return windowVolume(segmentID, epochOf(time)).volume;
+    }
+
+    // Up to k busiest segments over the window ending at time, busiest
+    // first. Candidates are the segments some epoch kept in its top-K; a
+    // segment never among an epoch's topCapacity peaks is not reported.
+    vector<BusySegment> busiest(size_t k, Clock::time_point time = Clock::now()) const {
+        long long now = epochOf(time);
+        unordered_set<string> candidates;
+        for (const Epoch& epoch : ring) {
+            if (!inWindow(epoch, now)) continue;
+            for (const PeakTopK::Entry& entry : epoch.busiest.entries()) candidates.insert(entry.key);
+        }
+        vector<BusySegment> segments;
+        for (const string& candidate : candidates) segments.push_back(windowVolume(candidate, now));
+        sort(segments.begin(), segments.end(), [](const BusySegment& a, const BusySegment& b) {
+            return a.volume != b.volume ? a.volume > b.volume : a.segmentID < b.segmentID;
+        });
+        if (segments.size() > k) segments.resize(k);
+        return segments;
+    }
+
+    double estimatedDistinctVehicles(Clock::time_point time = Clock::now()) const {
+        long long now = epochOf(time);
+        HyperLogLog window;
+        for (const Epoch& epoch : ring) {
+            if (inWindow(epoch, now)) window.merge(epoch.vehicles);
+        }
+        return window.estimate();
+    }
+
+    // Combine with sketches of the same window and epoch length, epoch by
+    // epoch; an epoch only the other side still holds replaces ours
+    void merge(const TrafficSketches& other) {
+        if (other.ring.size() != ring.size() || other.epochLength != epochLength) {
+            throw invalid_argument("sketches cover different windows");
+        }
+        for (const Epoch& theirs : other.ring) {
+            if (theirs.index < 0) continue;
+            Epoch* ours = slotFor(theirs.index);
+            if (!ours) continue;
+            ours->peaks.merge(theirs.peaks);
+            ours->busiest.merge(theirs.busiest);
+            ours->vehicles.merge(theirs.vehicles);
+        }
+    }
+};
+
+// Bounded single-producer/single-consumer ring buffer. The producer only
+// writes tail and the consumer only writes head, so push and pop need no
+// locks; each index sits on its own cache line to avoid false sharing.
+template <typename T>
+class SpscQueue {
+private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head{0};  // Next slot to pop
+    alignas(64) atomic<size_t> tail{0};  // Next slot to push
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Returns false (dropping value) if the queue is full
+    bool push(const T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) > mask) return false;
+        slots[t & mask] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        value = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+// Edge-triggered congestion event: the subscribed range started (congested)
+// or stopped exceeding its threshold
+struct CongestionAlert {
+    int subscriptionID;
+    int position;       // 1-based segment whose update caused the change
+    int rangeMax;       // Max over the subscribed range after the update
+    bool congested;
+};
+
+class TrafficMonitor {
+private:
+    AdaptiveCountArray trafficData;     // Vehicle counts indexed by segment handle
+    SegmentIDInterner segmentIDs;       // Road segment IDs interned to dense handles
+    bool linearSpace;                   // Range queries use BlockSparseTable instead of SparseTable
+    RangeTables<uint8_t> tables8;       // Range tables matching trafficData's storage width
+    RangeTables<uint16_t> tables16;
+    RangeTables<int32_t> tables32;
+    AdaptiveCountArray::Width tablesWidth;
+    vector<SegmentHandle> dirtyHandles; // Counts changed since the range tables were refreshed
+    bool tablesStale = false;           // Too much changed: rebuild instead of point updates
+    uint64_t segmentsVersion = 0;       // Bumped whenever a segment ID is added or deleted
+    uint64_t countsVersion = 0;         // Bumped whenever a count changes
+    static const size_t kCountLogSize = 4096;
+    vector<SegmentHandle> countLog;     // Handle whose count made version v, at v % kCountLogSize
+
+    // Congestion subscriptions: "max over 1-based [L, R] exceeds threshold".
+    // Each is listed in every kSubscriptionBucket-position bucket it
+    // overlaps, so an update only looks at the subscriptions covering it.
+    struct CongestionSubscription {
+        int L, R;
+        int threshold;
+        bool live;
+        bool congested;   // Last reported state
+        bool recheck;     // Listed in pendingRechecks
+    };
+    static const int kSubscriptionBucket = 64;
+    vector<CongestionSubscription> subscriptions;   // Indexed by subscription ID
+    vector<vector<int>> subscriptionBuckets;
+    vector<pair<int, int>> pendingRechecks;          // (subscription, position) of falling edges awaiting a rebuild
+    SpscQueue<CongestionAlert> alerts;
+    atomic<size_t> droppedAlerts{0};                 // Read by the alert consumer's thread
+    unique_ptr<TrafficSketches> sketches;   // Approximate analytics, when enabled
+
+    void countChanged(SegmentHandle handle) {
+        if (countLog.empty()) countLog.resize(kCountLogSize);
+        countLog[++countsVersion % kCountLogSize] = handle;
+    }
+
+    void pushAlert(const CongestionAlert& alert) {
+        if (!alerts.push(alert)) droppedAlerts.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Max over 1-based [L, R] from the range tables as they are; callers
+    // make sure no update is pending
+    int tableMax(int L, int R) {
+        return trafficData.visit([&](const auto& counts) { return tablesFor(counts).query(L - 1, R - 1, kMaxLane, linearSpace); });
+    }
+
+    // Report that a congested subscription cleared if its range max is no
+    // longer above the threshold. The range tables must be up to date.
+    void recheckCongestion(int id, int position) {
+        CongestionSubscription& subscription = subscriptions[id];
+        subscription.recheck = false;
+        if (!subscription.live || !subscription.congested) return;
+        int rangeMax = tableMax(subscription.L, subscription.R);
+        if (rangeMax > subscription.threshold) return;
+        subscription.congested = false;
+        pushAlert({id, position, rangeMax, false});
+    }
+
+    // Re-evaluate the subscriptions covering handle after its count went
+    // from oldCount to newCount. A rising edge needs no range query: the
+    // range was at or below the threshold, so newCount is its max. A
+    // falling edge is possible only when this segment was above the
+    // threshold; it takes a range max, answered after the pending point
+    // updates are applied, or left for the next rebuild when the tables
+    // need one (see markDirty).
+    void notifySubscribers(SegmentHandle handle, int oldCount, int newCount) {
+        if (subscriptions.empty() || oldCount == newCount) return;
+        int position = static_cast<int>(handle) + 1;
+        for (int id : subscriptionBuckets[handle / kSubscriptionBucket]) {
+            CongestionSubscription& subscription = subscriptions[id];
+            if (position < subscription.L || position > subscription.R) continue;
+
+            if (newCount > subscription.threshold) {
+                if (subscription.congested) continue;
+                subscription.congested = true;
+                pushAlert({id, position, newCount, true});
+            } else if (subscription.congested && oldCount > subscription.threshold) {
+                if (!tablesStale) {
+                    refreshRangeTables();
+                    recheckCongestion(id, position);
+                } else if (!subscription.recheck) {
+                    subscription.recheck = true;
+                    pendingRechecks.emplace_back(id, position);
+                }
+            }
+        }
+    }
+
+    RangeTables<uint8_t>& tablesFor(const ChunkedArray<uint8_t>&) { return tables8; }
+    RangeTables<uint16_t>& tablesFor(const ChunkedArray<uint16_t>&) { return tables16; }
+    RangeTables<int32_t>& tablesFor(const ChunkedArray<int32_t>&) { return tables32; }
+
+    void rebuildRangeTables() {
+        if (trafficData.storageWidth() != tablesWidth) {
+            // Counts were widened: drop the tables built at the old width
+            tables8.clear();
+            tables16.clear();
+            tables32.clear();
+            tablesWidth = trafficData.storageWidth();
+        }
+        trafficData.visit([this](const auto& counts) { tablesFor(counts).build(counts, linearSpace); });
+        dirtyHandles.clear();
+        tablesStale = false;
+    }
+
+    // Note that handle's count changed; the next refresh brings the range
+    // tables up to date with point updates. Once the counts were widened, or
+    // more than n / (log n + 1) positions are pending, the refresh rebuilds
+    // instead and positions stop being recorded: the list stays bounded, and
+    // that many updates would cost a rebuild even if each stopped after a
+    // level. The refresh also meters what the updates actually cost (see
+    // refreshRangeTables).
+    void markDirty(SegmentHandle handle) {
+        if (tablesStale) return;
+        size_t n = trafficData.size();
+        if (trafficData.storageWidth() != tablesWidth || (dirtyHandles.size() + 1) * (floorLog2((uint32_t)n) + 1) > n) {
+            tablesStale = true;
+            dirtyHandles.clear();
+            return;
+        }
+        dirtyHandles.push_back(handle);
+    }
+
+    // Apply pending changes to the range tables: point updates for the
+    // marked positions, or one rebuild if markDirty gave up on them. A point
+    // update that sets a new range extreme can touch about 2n cells rather
+    // than log n, so the cells the updates touch are counted, and once they
+    // pass what a rebuild computes the remaining updates are dropped for a
+    // rebuild. A refresh thus costs at most about two rebuilds.
+    void refreshRangeTables() {
+        if (tablesStale) {
+            rebuildRangeTables();
+            vector<pair<int, int>> rechecks;
+            rechecks.swap(pendingRechecks);
+            for (const auto& recheck : rechecks) recheckCongestion(recheck.first, recheck.second);
+            return;
+        }
+        if (dirtyHandles.empty()) return;
+        bool overBudget = trafficData.visit([this](const auto& counts) {
+            auto& tables = tablesFor(counts);
+            size_t budget = tables.buildCells(counts.size(), linearSpace), touched = 0;
+            for (SegmentHandle handle : dirtyHandles) {
+                touched += tables.update(handle, counts[handle], linearSpace);
+                if (touched > budget) return true;
+            }
+            return false;
+        });
+        dirtyHandles.clear();
+        if (overBudget) {
+            tablesStale = true;
+            refreshRangeTables();
+        }
+    }
+
+    // Make room for one more segment, doubling capacity when every position
+    // is taken so additions cost amortized O(log n)
+    void reserveForNewSegment() {
+        if (segmentIDs.size() >= trafficData.size()) growCapacity(max<size_t>(1, trafficData.size() * 2));
+    }
+
+public:
+    TrafficMonitor(int n, bool linearSpaceMode = false, unsigned buildThreads = defaultBuildThreads())
+        : trafficData(n), linearSpace(linearSpaceMode), tables8(buildThreads), tables16(buildThreads),
+          tables32(buildThreads), tablesWidth(trafficData.storageWidth()),
+          subscriptionBuckets((max(n, 1) + kSubscriptionBucket - 1) / kSubscriptionBucket), alerts(4096) {
+        rebuildRangeTables();
+    }
+
+    // Resolve an external segment ID to its handle (kInvalidSegment if unknown).
+    // Range queries use handle + 1 as the 1-based segment position.
+    SegmentHandle findSegment(const string& segmentID) const {
+        return segmentIDs.find(segmentID);
+    }
+
+    // Changes whenever a segment is added or deleted; a handle kept from
+    // before a change must be looked up again (it may now name another segment)
+    uint64_t segmentVersion() const { return segmentsVersion; }
+
+    // Changes whenever a vehicle count changes, so readers caching values
+    // derived from the counts can tell when to refresh them
+    uint64_t countVersion() const { return countsVersion; }
+
+    // Handles whose counts changed after version (repeats included), or
+    // false if too many changed since then to still be listed
+    bool countChangesSince(uint64_t version, vector<SegmentHandle>& handles) const {
+        handles.clear();
+        if (version > countsVersion || countsVersion - version > kCountLogSize) return false;
+        for (uint64_t v = version + 1; v <= countsVersion; v++) handles.push_back(countLog[v % kCountLogSize]);
+        return true;
+    }
+
+    // Number of segment positions currently allocated; grows as segments are added
+    int capacity() const { return static_cast<int>(trafficData.size()); }
+
+    // Extend to at least newCapacity positions, all with zero traffic.
+    // Handles, positions and subscriptions stay valid, and range tables that
+    // are up to date are extended over the new positions instead of rebuilt.
+    // Neither the counts nor the table cells already built move or are copied.
+    void growCapacity(size_t newCapacity) {
+        size_t oldCapacity = trafficData.size();
+        if (newCapacity <= oldCapacity) return;
+        trafficData.resize(newCapacity);
+        subscriptionBuckets.resize((newCapacity + kSubscriptionBucket - 1) / kSubscriptionBucket);
+        if (tablesStale) return;   // The next query rebuilds over every position anyway
+        // Pending point updates stay valid: they only touch old positions
+        trafficData.visit([this, oldCapacity](const auto& counts) {
+            tablesFor(counts).append(counts, oldCapacity, linearSpace);
+        });
+    }
+
+    // Add a segment without console output; returns its handle, or
+    // kInvalidSegment if it already exists
+    SegmentHandle registerSegment(const string& segmentID) {
+        if (segmentIDs.find(segmentID) != kInvalidSegment) return kInvalidSegment;
+        reserveForNewSegment();
+        segmentsVersion++;
+        return segmentIDs.intern(segmentID);
+    }
+
+    void addSegment(const string& segmentID) {
+        if (segmentIDs.find(segmentID) != kInvalidSegment) {
+            cout << "Segment already exists.\n";
+            return;
+        }
+
+        reserveForNewSegment();
+        segmentIDs.intern(segmentID);
+        segmentsVersion++;
+        cout << "Segment " << segmentID << " added successfully.\n";
+    }
+
+    void deleteSegment(const string& segmentID) {
+        SegmentHandle handle = segmentIDs.find(segmentID);
+        if (handle == kInvalidSegment) {
+            cout << "Segment not found.\n";
+            return;
+        }
+
+        int oldCount = trafficData[handle];
+        trafficData.set(handle, 0);
+        segmentIDs.release(handle);
+        segmentsVersion++;
+        countChanged(handle);
+        markDirty(handle);
+        refreshRangeTables();
+        notifySubscribers(handle, oldCount, 0);
+        cout << "Segment " << segmentID << " deleted successfully.\n";
+    }
+
+    void updateTrafficData(const string& segmentID, int vehicleCount) {
+        SegmentHandle handle = segmentIDs.find(segmentID);
+        if (handle == kInvalidSegment) {
+            cout << "Segment not found. Add the segment first.\n";
+            return;
+        }
+
+        updateTrafficData(handle, vehicleCount);
+        cout << "Traffic data for segment " << segmentID << " updated to " << vehicleCount << " vehicles.\n";
+    }
+
+    void updateTrafficData(SegmentHandle handle, int vehicleCount) {
+        if (!segmentIDs.isLive(handle)) return;
+        int oldCount = trafficData[handle];
+        trafficData.set(handle, vehicleCount);
+        countChanged(handle);
+        markDirty(handle);
+        refreshRangeTables();
+        notifySubscribers(handle, oldCount, vehicleCount);
+        if (sketches) sketches->recordTraffic(segmentIDs.name(handle), vehicleCount);
+    }
+
+    // Update a count without touching the range tables; the next max/min
+    // query applies every pending update at once (see markDirty)
+    void updateTrafficDataDeferred(SegmentHandle handle, int vehicleCount) {
+        if (!segmentIDs.isLive(handle)) return;
+        int oldCount = trafficData[handle];
+        trafficData.set(handle, vehicleCount);
+        countChanged(handle);
+        markDirty(handle);
+        notifySubscribers(handle, oldCount, vehicleCount);
+        if (sketches) sketches->recordTraffic(segmentIDs.name(handle), vehicleCount);
+    }
+
+    // Start feeding updates into approximate sketches over the last hour,
+    // keeping the topCapacity busiest segments of each minute; replaces any
+    // existing sketches
+    void enableSketches(size_t topCapacity = 64) { sketches.reset(new TrafficSketches(topCapacity)); }
+
+    // Sketches fed by this monitor, or nullptr if not enabled
+    TrafficSketches* trafficSketches() { return sketches.get(); }
+
+    // Count a vehicle sighting towards the distinct-vehicle estimate
+    void recordVehicle(const string& vehicleID) {
+        if (sketches) sketches->recordVehicle(vehicleID);
+    }
+
+    // Alert whenever max traffic over 1-based [L, R] starts or stops
+    // exceeding threshold. Returns the subscription ID, or -1 for an invalid
+    // range. A range already congested is reported immediately.
+    int subscribeCongestion(int L, int R, int threshold) {
+        if (L < 1 || L > R || R > capacity()) return -1;
+        int id = static_cast<int>(subscriptions.size());
+        int rangeMax = queryMaxTraffic(L, R);
+        bool congested = rangeMax > threshold;
+        subscriptions.push_back({L, R, threshold, true, congested, false});
+        for (int bucket = (L - 1) / kSubscriptionBucket; bucket <= (R - 1) / kSubscriptionBucket; bucket++) {
+            subscriptionBuckets[bucket].push_back(id);
+        }
+        if (congested) pushAlert({id, L, rangeMax, true});
+        return id;
+    }
+
+    bool unsubscribeCongestion(int id) {
+        if (id < 0 || id >= static_cast<int>(subscriptions.size()) || !subscriptions[id].live) return false;
+        CongestionSubscription& subscription = subscriptions[id];
+        subscription.live = false;
+        for (int bucket = (subscription.L - 1) / kSubscriptionBucket; bucket <= (subscription.R - 1) / kSubscriptionBucket; bucket++) {
+            vector<int>& ids = subscriptionBuckets[bucket];
+            ids.erase(find(ids.begin(), ids.end(), id));
+        }
+        return true;
+    }
+
+    // Take the oldest pending alert; safe to call from one consumer thread
+    // while updates run on another
+    bool pollCongestionAlert(CongestionAlert& alert) {
+        return alerts.pop(alert);
+    }
+
+    // Alerts lost because the queue was full
+    size_t droppedCongestionAlerts() const { return droppedAlerts.load(memory_order_relaxed); }
+
+    // Deliver falling-edge alerts left waiting for a range-table rebuild;
+    // called after each request batch so they do not wait for the next query
+    void settleCongestionAlerts() {
+        if (!pendingRechecks.empty()) refreshRangeTables();
+    }
+
+    int getTrafficData(const string& segmentID) const {
+        SegmentHandle handle = segmentIDs.find(segmentID);
+        if (handle == kInvalidSegment) {
+            cout << "No data found for segment ID: " << segmentID << endl;
+            return -1;
+        }
+        return trafficData[handle];
+    }
+
+    int getTrafficData(SegmentHandle handle) const {
+        return segmentIDs.isLive(handle) ? trafficData[handle] : -1;
+    }
+
+    int queryMaxTraffic(int L, int R) {
+        refreshRangeTables();
+        return trafficData.visit([&](const auto& counts) { return tablesFor(counts).query(L - 1, R - 1, kMaxLane, linearSpace); });
+    }
+
+    int queryMinTraffic(int L, int R) {
+        refreshRangeTables();
+        return trafficData.visit([&](const auto& counts) { return tablesFor(counts).query(L - 1, R - 1, kMinLane, linearSpace); });
+    }
+
+    // Maximum traffic for many 1-based [L, R] ranges in one call; invalid ranges yield -1
+    vector<int> queryMaxTrafficBatch(const vector<pair<int, int>>& ranges) {
+        vector<pair<int, int>> valid;
+        vector<size_t> positions;
+        for (size_t i = 0; i < ranges.size(); i++) {
+            int L = ranges[i].first, R = ranges[i].second;
+            if (L < 1 || R > static_cast<int>(trafficData.size()) || L > R) continue;
+            valid.emplace_back(L - 1, R - 1);
+            positions.push_back(i);
+        }
+
+        vector<int> validResults;
+        refreshRangeTables();
+        trafficData.visit([&](const auto& counts) {
+            tablesFor(counts).queryBatch(valid, validResults, kMaxLane, linearSpace);
+        });
+
+        vector<int> results(ranges.size(), -1);
+        for (size_t k = 0; k < positions.size(); k++) results[positions[k]] = validResults[k];
+        return results;
+    }
+
+    double queryAverageTraffic(int L, int R) {
+        if (L < 1 || R > trafficData.size() || L > R) {
+            cout << "Invalid range query.\n";
+            return -1;
+        }
+        return static_cast<double>(trafficData.sum(L - 1, R)) / (R - L + 1);
+    }
+
+    // Total traffic over 1-based [L, R]; the range must be valid
+    long long querySumTraffic(int L, int R) const {
+        return trafficData.sum(L - 1, R);
+    }
+
+    int queryTotalTraffic() {
+        return static_cast<int>(trafficData.sum(0, trafficData.size()));
+    }
+
+    void displayRankedSegments() const {
+        vector<pair<SegmentHandle, int>> rankedSegments;
+        for (SegmentHandle handle = 0; handle < segmentIDs.handleLimit(); handle++) {
+            if (segmentIDs.isLive(handle)) rankedSegments.emplace_back(handle, trafficData[handle]);
+        }
+        sort(rankedSegments.begin(), rankedSegments.end(), [](const auto& a, const auto& b) {
+            return a.second > b.second;
+        });
+
+        cout << "Segments ranked by traffic:\n";
+        for (const auto& segment : rankedSegments) {
+            cout << segmentIDs.name(segment.first) << ": " << segment.second << " vehicles\n";
+        }
+    }
+
+    void displayTrafficData() const {
+        cout << "Traffic Data for each Road Segment:\n";
+        for (SegmentHandle handle = 0; handle < segmentIDs.handleLimit(); handle++) {
+            if (!segmentIDs.isLive(handle)) continue;
+            cout << "Segment ID " << segmentIDs.name(handle) << ": " << trafficData[handle] << " vehicles\n";
+        }
+    }
+};
+
+// Binary request protocol for serving a TrafficMonitor over a socket.
+// Every request is a fixed 12-byte frame and every reply is one
+// little-endian int64, sent in request order, so clients can pipeline
+// freely. Segments are addressed by their 1-based position (handle + 1),
+// the same numbering the range queries use. Errors reply -1.
+enum TrafficOp : uint8_t {
+    kOpGet = 1,    // a = segment                -> vehicle count
+    kOpSet = 2,    // a = segment, b = count     -> 0
+    kOpMax = 3,    // a = L, b = R               -> maximum count
+    kOpMin = 4,    // a = L, b = R               -> minimum count
+    kOpSum = 5,    // a = L, b = R               -> total count
+    kOpTotal = 6,  //                            -> total over all segments
+    kOpCapacity = 7 //                           -> number of segment positions
+};
+
+struct TrafficRequest {
+    uint8_t op;
+    uint8_t reserved[3];
+    int32_t a;
+    int32_t b;
+};
+static_assert(sizeof(TrafficRequest) == 12, "TrafficRequest must be packed");
+
+static volatile sig_atomic_t stopServing = 0;
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool unixAddress(const string& path, sockaddr_un& address) {
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Endpoints are either a Unix socket path or "host:port" for TCP (e.g.
+// 127.0.0.1:7000). Returns true and fills address for the TCP form.
+static bool tcpAddress(const string& endpoint, sockaddr_in& address) {
+    size_t colon = endpoint.rfind(':');
+    if (colon == string::npos || endpoint.find('/') != string::npos) return false;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)atoi(endpoint.c_str() + colon + 1));
+    return inet_pton(AF_INET, endpoint.substr(0, colon).c_str(), &address.sin_addr) == 1;
+}
+
+// Bound, listening, non-blocking socket for an endpoint, or -1
+static int listenOn(const string& endpoint) {
+    sockaddr_in tcp;
+    sockaddr_un local;
+    int listener;
+    if (tcpAddress(endpoint, tcp)) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listener >= 0) setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (listener >= 0 && bind(listener, (sockaddr*)&tcp, sizeof(tcp)) != 0) {
+            close(listener);
+            return -1;
+        }
+    } else {
+        if (!unixAddress(endpoint, local)) return -1;
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(endpoint.c_str());
+        if (listener >= 0 && bind(listener, (sockaddr*)&local, sizeof(local)) != 0) {
+            close(listener);
+            return -1;
+        }
+    }
+    if (listener < 0 || listen(listener, SOMAXCONN) != 0 || !setNonBlocking(listener)) {
+        if (listener >= 0) close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+// Blocking connection to an endpoint, or -1. TCP connections disable
+// Nagle's algorithm, since requests are small and latency bound.
+static int connectTo(const string& endpoint) {
+    sockaddr_in tcp;
+    sockaddr_un local;
+    int fd;
+    if (tcpAddress(endpoint, tcp)) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&tcp, sizeof(tcp)) != 0) {
+            close(fd);
+            return -1;
+        }
+        int noDelay = 1;
+        if (fd >= 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    } else {
+        if (!unixAddress(endpoint, local)) return -1;
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&local, sizeof(local)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// Blocking send / receive of exactly size bytes
+static bool sendAll(int fd, const void* data, size_t size) {
+    const char* out = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, out, size, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        out += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, void* data, size_t size) {
+    char* in = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(fd, in, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        in += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+// Executes the complete requests in a connection's input in order. Updates
+// are deferred: the next MAX/MIN applies the SETs before it as point updates
+// to the range tables (or one rebuild if there are very many). GET and SUM
+// read the counts directly.
+class TrafficRequestBatch {
+private:
+    TrafficMonitor& monitor;
+
+    bool validSegment(int position) const { return position >= 1 && position <= monitor.capacity(); }
+    bool validRange(int L, int R) const { return L >= 1 && L <= R && R <= monitor.capacity(); }
+
+public:
+    explicit TrafficRequestBatch(TrafficMonitor& monitor) : monitor(monitor) {}
+
+    // Consume the whole frames in input[0, size), appending replies to output.
+    // Returns the number of bytes consumed.
+    size_t execute(const char* input, size_t size, string& output) {
+        size_t count = size / sizeof(TrafficRequest);
+        size_t replyStart = output.size();
+        output.resize(replyStart + count * sizeof(int64_t));
+        char* replies = &output[replyStart];
+
+        for (size_t i = 0; i < count; i++) {
+            TrafficRequest request;
+            memcpy(&request, input + i * sizeof(TrafficRequest), sizeof(request));
+            int64_t reply = -1;
+            switch (request.op) {
+            case kOpGet:
+                if (validSegment(request.a)) reply = monitor.getTrafficData((SegmentHandle)(request.a - 1));
+                break;
+            case kOpSet:
+                if (validSegment(request.a) && request.b >= 0) {
+                    monitor.updateTrafficDataDeferred((SegmentHandle)(request.a - 1), request.b);
+                    reply = 0;
+                }
+                break;
+            case kOpMax:
+                if (validRange(request.a, request.b)) reply = monitor.queryMaxTraffic(request.a, request.b);
+                break;
+            case kOpMin:
+                if (validRange(request.a, request.b)) reply = monitor.queryMinTraffic(request.a, request.b);
+                break;
+            case kOpSum:
+                if (validRange(request.a, request.b)) reply = monitor.querySumTraffic(request.a, request.b);
+                break;
+            case kOpTotal:
+                reply = monitor.queryTotalTraffic();
+                break;
+            case kOpCapacity:
+                reply = monitor.capacity();
+                break;
+            }
+            memcpy(replies + i * sizeof(int64_t), &reply, sizeof(reply));
+        }
+        monitor.settleCongestionAlerts();
+        return count * sizeof(TrafficRequest);
+    }
+};
+
+// Single-threaded epoll server on an already listening socket. Each
+// readable connection is drained, every complete request in the buffer is
+// executed as one batch, and replies are written back with as few syscalls
+// as the socket allows. Runs until SIGINT/SIGTERM, then closes listener.
+int serveTraffic(int listener, TrafficMonitor& monitor, const string& endpoint) {
+    struct Connection {
+        string input, output;
+        size_t outputSent = 0;
+    };
+
+    int epollFd = epoll_create1(0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &event);
+
+    signal(SIGINT, [](int) { stopServing = 1; });
+    signal(SIGTERM, [](int) { stopServing = 1; });
+    signal(SIGPIPE, SIG_IGN);
+
+    unordered_map<int, Connection> connections;
+    TrafficRequestBatch batch(monitor);
+    vector<epoll_event> events(256);
+    char buffer[64 * 1024];
+    cout << "Serving " << monitor.capacity() << " segments on " << endpoint << endl;
+
+    auto closeConnection = [&](int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+
+    // Write as much pending output as the socket takes; watch for EPOLLOUT
+    // only while some is left. Returns false if the peer is gone.
+    auto flushOutput = [&](int fd, Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t sent = send(fd, connection.output.data() + connection.outputSent,
+                                connection.output.size() - connection.outputSent, 0);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+                epoll_event update{};
+                update.events = EPOLLIN | EPOLLOUT;
+                update.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &update);
+                return true;
+            }
+            connection.outputSent += (size_t)sent;
+        }
+        connection.output.clear();
+        connection.outputSent = 0;
+        epoll_event update{};
+        update.events = EPOLLIN;
+        update.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &update);
+        return true;
+    };
+
+    while (!stopServing) {
+        int ready = epoll_wait(epollFd, events.data(), (int)events.size(), 200);
+        if (ready < 0 && errno != EINTR) break;
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listener) {
+                int client;
+                while ((client = accept(listener, nullptr, nullptr)) >= 0) {
+                    setNonBlocking(client);
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN;
+                    clientEvent.data.fd = client;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &clientEvent);
+                    connections[client];
+                }
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = it->second;
+            bool alive = true;
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                while (true) {
+                    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                    if (received > 0) {
+                        connection.input.append(buffer, (size_t)received);
+                        if ((size_t)received < sizeof(buffer)) break;
+                    } else if (received == 0) {
+                        alive = false;
+                        break;
+                    } else {
+                        if (errno == EINTR) continue;
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) alive = false;
+                        break;
+                    }
+                }
+                size_t consumed = batch.execute(connection.input.data(), connection.input.size(), connection.output);
+                connection.input.erase(0, consumed);
+            }
+            if (!connection.output.empty() && !flushOutput(fd, connection)) alive = false;
+            if (!alive) closeConnection(fd);
+        }
+    }
+
+    for (auto& entry : connections) close(entry.first);
+    close(listener);
+    close(epollFd);
+    cout << "Server stopped.\n";
+    return 0;
+}
+
+// Serve monitor on an endpoint (Unix socket path or TCP host:port)
+int runTrafficServer(const string& endpoint, TrafficMonitor& monitor) {
+    sockaddr_in tcp;
+    bool isTcp = tcpAddress(endpoint, tcp);
+    int listener = listenOn(endpoint);
+    if (listener < 0) {
+        cerr << "Cannot listen on " << endpoint << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    int status = serveTraffic(listener, monitor, endpoint);
+    if (!isTcp) unlink(endpoint.c_str());
+    return status;
+}
+
+// Load generator for runTrafficServer: each thread opens one connection and
+// keeps `depth` requests in flight (a mix of 90% range/point reads and 10%
+// updates over `segments` positions) for the given number of seconds.
+int runTrafficLoadGenerator(const string& endpoint, int connections, int seconds, int depth, int segments) {
+    if (connections < 1 || depth < 1 || segments < 1) {
+        cerr << "Invalid load generator arguments.\n";
+        return 1;
+    }
+
+    atomic<long long> completed(0);
+    atomic<bool> failed(false);
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(max(seconds, 1));
+
+    auto client = [&](unsigned seed) {
+        int fd = connectTo(endpoint);
+        if (fd < 0) {
+            failed = true;
+            return;
+        }
+        vector<TrafficRequest> requests(depth);
+        vector<int64_t> replies(depth);
+        uint32_t state = seed * 2654435761u + 1;
+        auto next = [&]() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        };
+
+        long long done = 0;
+        while (chrono::steady_clock::now() < deadline) {
+            for (TrafficRequest& request : requests) {
+                uint32_t r = next();
+                int a = 1 + (int)(next() % segments);
+                int b = a + (int)(next() % min(segments - a + 1, 64));
+                request = TrafficRequest{};
+                switch (r % 10) {
+                case 0: request.op = kOpSet; request.a = a; request.b = (int)(next() % 200); break;
+                case 1: case 2: request.op = kOpGet; request.a = a; break;
+                case 3: case 4: case 5: request.op = kOpMax; request.a = a; request.b = b; break;
+                case 6: case 7: request.op = kOpMin; request.a = a; request.b = b; break;
+                default: request.op = kOpSum; request.a = a; request.b = b; break;
+                }
+            }
+            if (!sendAll(fd, requests.data(), requests.size() * sizeof(TrafficRequest)) ||
+                !receiveAll(fd, replies.data(), replies.size() * sizeof(int64_t))) {
+                failed = true;
+                break;
+            }
+            done += depth;
+        }
+        completed += done;
+        close(fd);
+    };
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < connections; i++) threads.emplace_back(client, (unsigned)i + 1);
+    for (thread& t : threads) t.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << completed.load() << " requests over " << connections << " connections (depth " << depth << ") in "
+         << elapsed << " s: " << (long long)(completed.load() / elapsed) << " ops/sec\n";
+    return failed ? 1 : 0;
+}
+
+// Coordinator for a city partitioned across shard processes. Each shard is
+// a TrafficMonitor served by runTrafficServer, locally or on another host.
+// A shard holds one contiguous run of global segment positions in its own
+// positions 1..count, and its range tables answer queries over that run. A
+// cross-shard query is split into one local range per shard. Requests are
+// written to every shard before any reply is read, so the shards work
+// concurrently, and their partial max/min/sum results are merged here.
+// Positions a shard has room for but does not hold are kept at 0.
+class ShardedTrafficMonitor {
+private:
+    struct Shard {
+        string endpoint;
+        int fd;
+        int capacity;   // Positions the shard process was sized for
+        int first;      // Global position stored at its local position 1
+        int count;      // Global positions it holds
+    };
+
+    vector<Shard> shards;
+    int segments = 0;   // Global positions 1..segments are in use
+
+    static TrafficRequest makeRequest(uint8_t op, int a = 0, int b = 0) {
+        TrafficRequest request{};
+        request.op = op;
+        request.a = a;
+        request.b = b;
+        return request;
+    }
+
+    // Send requests[k] to shard k, then collect the replies. Every shard
+    // has its whole share before the first reply is awaited.
+    bool exchange(const vector<vector<TrafficRequest>>& requests, vector<vector<int64_t>>& replies) const {
+        replies.assign(shards.size(), {});
+        for (size_t k = 0; k < shards.size(); k++) {
+            if (!requests[k].empty() &&
+                !sendAll(shards[k].fd, requests[k].data(), requests[k].size() * sizeof(TrafficRequest))) {
+                return false;
+            }
+        }
+        for (size_t k = 0; k < shards.size(); k++) {
+            replies[k].resize(requests[k].size());
+            if (!requests[k].empty() &&
+                !receiveAll(shards[k].fd, replies[k].data(), replies[k].size() * sizeof(int64_t))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Shard holding a global position, or -1. Shards hold consecutive runs
+    // in order, so this is the last shard starting at or before position
+    // (an empty shard starts where the next one does and never wins).
+    int shardOf(int position) const {
+        auto after = upper_bound(shards.begin(), shards.end(), position,
+                                 [](int target, const Shard& shard) { return target < shard.first; });
+        if (after == shards.begin()) return -1;
+        int k = (int)(after - shards.begin()) - 1;
+        return position < shards[k].first + shards[k].count ? k : -1;
+    }
+
+    // Run op over global [L, R] on every shard it touches and merge the
+    // partial results; -1 on an invalid range or a failed shard
+    int64_t rangeQuery(uint8_t op, int L, int R) const {
+        if (L < 1 || L > R || R > segments) return -1;
+        vector<vector<TrafficRequest>> requests(shards.size());
+        for (size_t k = 0; k < shards.size(); k++) {
+            int from = max(L, shards[k].first), to = min(R, shards[k].first + shards[k].count - 1);
+            if (from <= to) {
+                requests[k].push_back(makeRequest(op, from - shards[k].first + 1, to - shards[k].first + 1));
+            }
+        }
+        vector<vector<int64_t>> replies;
+        if (!exchange(requests, replies)) return -1;
+
+        int64_t merged = op == kOpMin ? numeric_limits<int64_t>::max() : op == kOpMax ? -1 : 0;
+        for (const vector<int64_t>& shardReplies : replies) {
+            for (int64_t reply : shardReplies) {
+                if (reply < 0) return -1;
+                merged = op == kOpMax ? max(merged, reply) : op == kOpMin ? min(merged, reply) : merged + reply;
+            }
+        }
+        return merged;
+    }
+
+    // Re-split positions 1..segments over the shards in proportion to their
+    // capacity, then move every count whose shard or local position changed.
+    // Costs one pipelined read and one pipelined write of the network.
+    bool rebalance() {
+        vector<int> counts;
+        if (!readAllTrafficData(counts)) return false;
+        counts.resize(segments, 0);   // Positions added since the last layout start at 0
+
+        long long totalCapacity = capacity();
+        vector<int> newCount(shards.size());
+        int assigned = 0;
+        for (size_t k = 0; k < shards.size(); k++) {
+            newCount[k] = (int)((long long)segments * shards[k].capacity / totalCapacity);
+            assigned += newCount[k];
+        }
+        for (size_t k = 0; assigned < segments; k = (k + 1) % shards.size()) {
+            if (newCount[k] < shards[k].capacity) {
+                newCount[k]++;
+                assigned++;
+            }
+        }
+
+        vector<vector<TrafficRequest>> requests(shards.size());
+        int first = 1;
+        for (size_t k = 0; k < shards.size(); k++) {
+            Shard& shard = shards[k];
+            if (shard.first != first || shard.count != newCount[k]) {
+                for (int i = 0; i < newCount[k]; i++) requests[k].push_back(makeRequest(kOpSet, i + 1, counts[first - 1 + i]));
+                for (int i = newCount[k]; i < shard.count; i++) requests[k].push_back(makeRequest(kOpSet, i + 1, 0));
+            }
+            shard.first = first;
+            shard.count = newCount[k];
+            first += newCount[k];
+        }
+        vector<vector<int64_t>> replies;
+        return exchange(requests, replies);
+    }
 
 public:
-    SparseTable() {}
+    ShardedTrafficMonitor() {}
 
-    void buildLogTable(int n) {
-        logTable.assign(n + 1, 0);
-        for (int i = 2; i <= n; i++) {
-            logTable[i] = logTable[i / 2] + 1;
-        }
+    ~ShardedTrafficMonitor() {
+        for (Shard& shard : shards) close(shard.fd);
     }
 
-    void buildSparseTable(const vector<int>& arr) {
-        int n = arr.size();
-        int logN = log2(n) + 1;
+    ShardedTrafficMonitor(const ShardedTrafficMonitor&) = delete;
+    ShardedTrafficMonitor& operator=(const ShardedTrafficMonitor&) = delete;
+
+    // Global positions in use
+    int size() const { return segments; }
+
+    // Positions all shards together can hold
+    int capacity() const {
+        int total = 0;
+        for (const Shard& shard : shards) total += shard.capacity;
+        return total;
+    }
 
-        maxTable.assign(n, vector<int>(logN, 0));
-        minTable.assign(n, vector<int>(logN, INT_MAX));
+    // Connect to a shard server and spread the current segments over every
+    // shard, this one included. Returns false if it cannot be reached.
+    bool addShard(const string& endpoint) {
+        int fd = connectTo(endpoint);
+        if (fd < 0) return false;
+        TrafficRequest ask = makeRequest(kOpCapacity);
+        int64_t shardCapacity = -1;
+        if (!sendAll(fd, &ask, sizeof(ask)) || !receiveAll(fd, &shardCapacity, sizeof(shardCapacity)) ||
+            shardCapacity < 1) {
+            close(fd);
+            return false;
+        }
+        shards.push_back({endpoint, fd, (int)shardCapacity, segments + 1, 0});
+        return rebalance();
+    }
 
-        for (int i = 0; i < n; i++) {
-            maxTable[i][0] = arr[i];
-            minTable[i][0] = arr[i];
+    // Extend the network to newSize positions; new positions start at 0.
+    // They go to the last shard while it has room, otherwise the shards are
+    // rebalanced. Returns false if the shards cannot hold newSize.
+    bool grow(int newSize) {
+        if (newSize <= segments) return newSize == segments;
+        if (newSize > capacity()) return false;
+        int added = newSize - segments;
+        segments = newSize;
+        if (shards.back().count + added <= shards.back().capacity) {
+            shards.back().count += added;
+            return true;
         }
+        return rebalance();
+    }
+
+    int getTrafficData(int position) const {
+        int k = shardOf(position);
+        if (k < 0) return -1;
+        TrafficRequest request = makeRequest(kOpGet, position - shards[k].first + 1);
+        int64_t reply = -1;
+        if (!sendAll(shards[k].fd, &request, sizeof(request)) || !receiveAll(shards[k].fd, &reply, sizeof(reply))) return -1;
+        return (int)reply;
+    }
+
+    bool updateTrafficData(int position, int vehicleCount) {
+        int k = shardOf(position);
+        if (k < 0 || vehicleCount < 0) return false;
+        TrafficRequest request = makeRequest(kOpSet, position - shards[k].first + 1, vehicleCount);
+        int64_t reply = -1;
+        return sendAll(shards[k].fd, &request, sizeof(request)) && receiveAll(shards[k].fd, &reply, sizeof(reply)) && reply == 0;
+    }
 
-        for (int j = 1; (1 << j) <= n; j++) {
-            for (int i = 0; i + (1 << j) <= n; i++) {
-                maxTable[i][j] = max(maxTable[i][j - 1], maxTable[i + (1 << (j - 1))][j - 1]);
-                minTable[i][j] = min(minTable[i][j - 1], minTable[i + (1 << (j - 1))][j - 1]);
+    // Set positions first, first + 1, ... to counts in one pipelined round
+    bool loadTrafficData(int first, const vector<int>& counts) {
+        if (first < 1 || (long long)first + (long long)counts.size() - 1 > segments) return false;
+        vector<vector<TrafficRequest>> requests(shards.size());
+        int k = counts.empty() ? 0 : shardOf(first);
+        for (size_t i = 0; i < counts.size(); i++) {
+            int position = first + (int)i;
+            while (position >= shards[k].first + shards[k].count) k++;   // Positions are consecutive
+            requests[k].push_back(makeRequest(kOpSet, position - shards[k].first + 1, counts[i]));
+        }
+        vector<vector<int64_t>> replies;
+        if (!exchange(requests, replies)) return false;
+        for (const vector<int64_t>& shardReplies : replies) {
+            for (int64_t reply : shardReplies) {
+                if (reply != 0) return false;
             }
         }
+        return true;
+    }
+
+    // Counts of every position the shards currently hold, in global order
+    bool readAllTrafficData(vector<int>& counts) const {
+        vector<vector<TrafficRequest>> requests(shards.size());
+        for (size_t k = 0; k < shards.size(); k++) {
+            for (int i = 1; i <= shards[k].count; i++) requests[k].push_back(makeRequest(kOpGet, i));
+        }
+        vector<vector<int64_t>> replies;
+        if (!exchange(requests, replies)) return false;
+        counts.clear();
+        for (const vector<int64_t>& shardReplies : replies) {
+            for (int64_t reply : shardReplies) counts.push_back((int)reply);
+        }
+        return true;
     }
 
-    int queryMax(int L, int R) {
-        L--; R--;
-        int j = logTable[R - L + 1];
-        return max(maxTable[L][j], maxTable[R - (1 << j) + 1][j]);
+    int queryMaxTraffic(int L, int R) const { return (int)rangeQuery(kOpMax, L, R); }
+    int queryMinTraffic(int L, int R) const { return (int)rangeQuery(kOpMin, L, R); }
+    long long querySumTraffic(int L, int R) const { return rangeQuery(kOpSum, L, R); }
+
+    double queryAverageTraffic(int L, int R) const {
+        long long sum = rangeQuery(kOpSum, L, R);
+        return sum < 0 ? -1 : static_cast<double>(sum) / (R - L + 1);
     }
 
-    int queryMin(int L, int R) {
-        L--; R--;
-        int j = logTable[R - L + 1];
-        return min(minTable[L][j], minTable[R - (1 << j) + 1][j]);
+    void displayLayout() const {
+        for (const Shard& shard : shards) {
+            cout << shard.endpoint << ": positions " << shard.first << "-" << shard.first + shard.count - 1
+                 << " (" << shard.count << " of " << shard.capacity << ")\n";
+        }
     }
 };
 
-class TrafficMonitor {
+// Local end-to-end check of ShardedTrafficMonitor: forks numShards shard
+// servers on loopback TCP ports, builds the network on all but the last,
+// then grows it past their capacity so the last shard has to join and the
+// layout is rebalanced. Point updates and random cross-shard max/min/average
+// queries are compared with an in-process copy of the counts, and the
+// coordinator's query rate is reported for each phase.
+int runShardDemo(int numShards, int segmentsPerShard) {
+    if (numShards < 2 || segmentsPerShard < 1) {
+        cerr << "Need at least 2 shards and a positive shard size.\n";
+        return 1;
+    }
+
+    // Bind every port before forking, so no shard races for one
+    vector<int> listeners;
+    vector<string> endpoints;
+    for (int i = 0; i < numShards; i++) {
+        int listener = listenOn("127.0.0.1:0");
+        sockaddr_in bound;
+        socklen_t length = sizeof(bound);
+        if (listener < 0 || getsockname(listener, (sockaddr*)&bound, &length) != 0) {
+            cerr << "Cannot listen on loopback: " << strerror(errno) << endl;
+            return 1;
+        }
+        listeners.push_back(listener);
+        endpoints.push_back("127.0.0.1:" + to_string(ntohs(bound.sin_port)));
+    }
+    cout.flush();
+    vector<pid_t> children;
+    for (int i = 0; i < numShards; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            for (int j = 0; j < numShards; j++) {
+                if (j != i) close(listeners[j]);
+            }
+            TrafficMonitor monitor(segmentsPerShard);
+            for (int p = 1; p <= segmentsPerShard; p++) monitor.registerSegment("S" + to_string(p));
+            int status = serveTraffic(listeners[i], monitor, endpoints[i]);
+            cout.flush();
+            _exit(status);
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    for (int listener : listeners) close(listener);
+
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    vector<int> expected;
+    ShardedTrafficMonitor cluster;
+    int mismatches = 0;
+
+    // Random max/min/average queries, about half spanning several shards
+    auto checkQueries = [&](const string& phase, int queries) {
+        int n = cluster.size();
+        double seconds = 0;
+        for (int q = 0; q < queries; q++) {
+            int L = 1 + (int)(next() % n);
+            int span = q % 2 ? 64 : n;
+            int R = L + (int)(next() % min(span, n - L + 1));
+            auto first = expected.begin() + (L - 1), last = expected.begin() + R;
+            auto start = chrono::steady_clock::now();
+            bool match;
+            if (q % 3 == 0) {
+                match = cluster.queryMaxTraffic(L, R) == *max_element(first, last);
+            } else if (q % 3 == 1) {
+                match = cluster.queryMinTraffic(L, R) == *min_element(first, last);
+            } else {
+                double average = cluster.queryAverageTraffic(L, R);
+                match = average == static_cast<double>(accumulate(first, last, 0LL)) / (R - L + 1);
+            }
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (!match) mismatches++;
+        }
+        cout << phase << ": " << queries << " range queries over " << n << " segments in " << seconds * 1000
+             << " ms (" << (long long)(queries / max(seconds, 1e-9)) << " queries/sec), " << mismatches
+             << " mismatches so far\n";
+    };
+
+    // Compare every position the shards hold with the local copy
+    auto checkContents = [&](const string& phase) {
+        vector<int> counts;
+        if (!cluster.readAllTrafficData(counts) || counts != expected) {
+            mismatches++;
+            cout << phase << ": shard contents differ from the expected counts\n";
+        }
+    };
+
+    bool ok = true;
+    for (int i = 0; i + 1 < numShards; i++) ok = ok && cluster.addShard(endpoints[i]);
+    int initial = (numShards - 1) * segmentsPerShard * 9 / 10;
+    ok = ok && cluster.grow(initial);
+    expected.resize(initial);
+    for (int& count : expected) count = (int)(next() % 500);
+    ok = ok && cluster.loadTrafficData(1, expected);
+    for (int i = 0; i < 1000 && ok; i++) {
+        int position = 1 + (int)(next() % initial), count = (int)(next() % 500);
+        ok = cluster.updateTrafficData(position, count);
+        expected[position - 1] = count;
+    }
+    if (ok) {
+        checkContents("Initial layout");
+        checkQueries("Initial layout", 3000);
+
+        // Outgrow the first shards: the last one joins and takes a share
+        int grown = (numShards - 1) * segmentsPerShard + segmentsPerShard / 2;
+        if (cluster.grow(grown)) {
+            cout << "Unexpected: network grew past its shards' capacity\n";
+            mismatches++;
+        }
+        ok = cluster.addShard(endpoints.back()) && cluster.grow(grown);
+        vector<int> added(grown - initial);
+        for (int& count : added) count = (int)(next() % 500);
+        expected.insert(expected.end(), added.begin(), added.end());
+        ok = ok && cluster.loadTrafficData(initial + 1, added);
+    }
+    if (ok) {
+        cluster.displayLayout();
+        checkContents("After rebalancing");
+        checkQueries("After rebalancing", 3000);
+    } else {
+        cout << "Lost contact with a shard.\n";
+    }
+
+    for (pid_t pid : children) kill(pid, SIGTERM);
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+    return ok && mismatches == 0 ? 0 : 1;
+}
+
+// Workload replay for TrafficMonitor. A trace is a text file with one
+// operation per line: an op letter and its arguments. Positions are 1-based
+// as in the menu. --generate writes a random trace; --replay runs it through
+// a naive reference and through TrafficMonitor in both range-table modes,
+// times each and reports the first answer that differs.
+//
+//   N n                    segments S1..Sn, all starting at 0 (first line)
+//   A name                 add segment (-> position, 0 if it exists)
+//   D name                 delete segment
+//   U name count           update a segment
+//   W name count           deferred update, applied by the next max/min query
+//   G capacity             grow to at least capacity positions (-> capacity)
+//   Q L R / M L R / S L R  maximum / minimum / total over [L, R]
+//   B L1 R1 L2 R2 ...      batch of maximum queries (invalid ranges -> -1)
+
+// Reference for TrafficMonitor: plain counts scanned per query, with the
+// same handle reuse and capacity doubling as SegmentIDInterner and
+// TrafficMonitor::reserveForNewSegment
+class ReferenceTraffic {
 private:
-    vector<int> trafficData;
-    unordered_map<string, int> segmentMap;
-    SparseTable sparseTable;
+    vector<int> counts;
+    vector<string> names;                       // names[handle], "" once deleted
+    vector<SegmentHandle> freeHandles;
+    unordered_map<string, SegmentHandle> handles;
 
 public:
-    TrafficMonitor(int n) {
-        trafficData.resize(n, 0);
-        sparseTable.buildLogTable(n);
+    explicit ReferenceTraffic(int n) : counts(n, 0) {}
+
+    SegmentHandle findSegment(const string& segmentID) const {
+        auto it = handles.find(segmentID);
+        return it == handles.end() ? kInvalidSegment : it->second;
     }
 
-    void addSegment(const string& segmentID) {
-        if (segmentMap.find(segmentID) != segmentMap.end()) {
-            cout << "Segment already exists.\n";
-            return;
+    int capacity() const { return static_cast<int>(counts.size()); }
+
+    void growCapacity(size_t newCapacity) {
+        if (newCapacity > counts.size()) counts.resize(newCapacity, 0);
+    }
+
+    SegmentHandle registerSegment(const string& segmentID) {
+        if (handles.count(segmentID)) return kInvalidSegment;
+        if (handles.size() >= counts.size()) growCapacity(max<size_t>(1, counts.size() * 2));
+        SegmentHandle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+            names[handle] = segmentID;
+        } else {
+            handle = static_cast<SegmentHandle>(names.size());
+            names.push_back(segmentID);
         }
+        handles[segmentID] = handle;
+        return handle;
+    }
 
-        if (segmentMap.size() >= trafficData.size()) {
-            cout << "Error: Maximum number of segments reached. Cannot add more segments.\n";
-            return;
+    void deleteSegment(const string& segmentID) {
+        auto it = handles.find(segmentID);
+        if (it == handles.end()) return;
+        counts[it->second] = 0;
+        names[it->second].clear();
+        freeHandles.push_back(it->second);
+        handles.erase(it);
+    }
+
+    void updateTrafficData(SegmentHandle handle, int vehicleCount) {
+        if (handle < names.size() && !names[handle].empty()) counts[handle] = vehicleCount;
+    }
+
+    void updateTrafficDataDeferred(SegmentHandle handle, int vehicleCount) { updateTrafficData(handle, vehicleCount); }
+
+    int queryMaxTraffic(int L, int R) { return *max_element(counts.begin() + (L - 1), counts.begin() + R); }
+    int queryMinTraffic(int L, int R) { return *min_element(counts.begin() + (L - 1), counts.begin() + R); }
+    long long querySumTraffic(int L, int R) const { return accumulate(counts.begin() + (L - 1), counts.begin() + R, 0LL); }
+
+    vector<int> queryMaxTrafficBatch(const vector<pair<int, int>>& ranges) {
+        vector<int> results;
+        for (const auto& range : ranges) {
+            bool valid = range.first >= 1 && range.first <= range.second && range.second <= capacity();
+            results.push_back(valid ? queryMaxTraffic(range.first, range.second) : -1);
         }
+        return results;
+    }
+};
 
-        segmentMap[segmentID] = segmentMap.size();
-        cout << "Segment " << segmentID << " added successfully.\n";
+// Answer one trace op on a TrafficMonitor or the reference
+template <typename Monitor>
+string applyToMonitor(Monitor& monitor, const TraceOp& op) {
+    auto range = [&](size_t i) {
+        int L = stoi(op.args.at(i)), R = stoi(op.args.at(i + 1));
+        if (L < 1 || R > monitor.capacity() || L > R) throw out_of_range("range " + op.args[i] + " " + op.args[i + 1]);
+        return make_pair(L, R);
+    };
+    switch (op.op) {
+        case 'A': {
+            SegmentHandle handle = monitor.registerSegment(op.args.at(0));
+            return to_string(handle == kInvalidSegment ? 0 : handle + 1);
+        }
+        case 'D':
+            monitor.deleteSegment(op.args.at(0));
+            return "";
+        case 'U':
+            monitor.updateTrafficData(monitor.findSegment(op.args.at(0)), stoi(op.args.at(1)));
+            return "";
+        case 'W':
+            monitor.updateTrafficDataDeferred(monitor.findSegment(op.args.at(0)), stoi(op.args.at(1)));
+            return "";
+        case 'G':
+            monitor.growCapacity(stoul(op.args.at(0)));
+            return to_string(monitor.capacity());
+        case 'Q': {
+            auto r = range(0);
+            return to_string(monitor.queryMaxTraffic(r.first, r.second));
+        }
+        case 'M': {
+            auto r = range(0);
+            return to_string(monitor.queryMinTraffic(r.first, r.second));
+        }
+        case 'S': {
+            auto r = range(0);
+            return to_string(monitor.querySumTraffic(r.first, r.second));
+        }
+        case 'B': {
+            if (op.args.empty() || op.args.size() % 2) throw invalid_argument("B takes L R pairs");
+            vector<pair<int, int>> ranges;
+            for (size_t i = 0; i < op.args.size(); i += 2) ranges.emplace_back(stoi(op.args[i]), stoi(op.args[i + 1]));
+            vector<string> results;
+            for (int result : monitor.queryMaxTrafficBatch(ranges)) results.push_back(to_string(result));
+            return joinAnswer(results);
+        }
+        default:
+            return "";
+    }
+}
+
+// Write a random trace starting from the given number of segments. Segments
+// are added (growing capacity) and deleted (freeing positions for reuse);
+// counts are mostly small, with occasional ones that widen the storage.
+// Ranges are a mix of short windows and arbitrary spans.
+bool generateTrafficTrace(const string& path, long long operations, int segments, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    ReferenceTraffic shadow(segments);   // Tracks capacity, so every range is valid
+    vector<string> live;
+    for (int i = 1; i <= segments; i++) {
+        live.push_back("S" + to_string(i));
+        shadow.registerSegment(live.back());
     }
+    int nextName = segments + 1;
+    auto range = [&]() {
+        int n = shadow.capacity();
+        int L = 1 + rng() % n;
+        int span = rng() % 2 ? 64 : n;
+        int R = L + (int)(rng() % min(span, n - L + 1));
+        return to_string(L) + " " + to_string(R);
+    };
+    auto count = [&]() {
+        unsigned kind = rng() % 100;
+        return kind < 97 ? rng() % 256 : kind < 99 ? rng() % 70000 : rng() % 10000000;
+    };
 
-    void deleteSegment(const string& segmentID) {
-        if (segmentMap.find(segmentID) == segmentMap.end()) {
-            cout << "Segment not found.\n";
+    out << "# TrafficMonitor trace, seed " << seed << "\n";
+    out << "N " << segments << "\n";
+    for (long long i = 0; i < operations; i++) {
+        unsigned kind = rng() % 40;
+        if (kind == 0) {
+            string name = rng() % 8 || live.empty() ? "S" + to_string(nextName++) : live[rng() % live.size()];
+            if (shadow.registerSegment(name) != kInvalidSegment) live.push_back(name);
+            out << "A " << name << "\n";
+        } else if (kind == 1 && !live.empty()) {
+            size_t victim = rng() % live.size();
+            out << "D " << live[victim] << "\n";
+            shadow.deleteSegment(live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        } else if (kind == 2 && rng() % 8 == 0) {
+            int capacity = shadow.capacity() + 1 + rng() % 64;
+            shadow.growCapacity(capacity);
+            out << "G " << capacity << "\n";
+        } else if (kind < 10 && !live.empty()) {
+            out << (kind < 6 ? "U " : "W ") << live[rng() % live.size()] << " " << count() << "\n";
+        } else if (kind < 12) {
+            out << "B";
+            for (int r = 0; r < 8; r++) out << " " << range();
+            out << "\n";
+        } else {
+            out << "QMS"[kind % 3] << " " << range() << "\n";
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and TrafficMonitor in both range
+// table modes; returns the exit code
+int replayTrafficTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    if (trace.empty() || trace[0].op != 'N' || trace[0].args.empty() || atoi(trace[0].args[0].c_str()) < 1) {
+        cerr << "Trace must start with N <segments>.\n";
+        return 1;
+    }
+    int n = atoi(trace[0].args[0].c_str());
+    try {
+        vector<string> expected, answers;
+        ReferenceTraffic reference(n);
+        for (int i = 1; i <= n; i++) reference.registerSegment("S" + to_string(i));
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return applyToMonitor(reference, op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        for (bool linearSpace : {false, true}) {
+            TrafficMonitor monitor(n, linearSpace);
+            for (int i = 1; i <= n; i++) monitor.registerSegment("S" + to_string(i));
+            {
+                QuietOutput quiet;   // deleteSegment reports on cout
+                seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToMonitor(monitor, op); });
+            }
+            matched = reportRun(linearSpace ? "TrafficMonitor (linear space)" : "TrafficMonitor", trace, seconds,
+                                answers, &expected) && matched;
+        }
+        return matched ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
+// Customizable contraction hierarchy over RoadGraph's edges. The work is
+// split so that live traffic never repeats the expensive part:
+//  - build ranks the nodes by nested dissection (recursive median cuts of
+//    the coordinates, each cut's boundary ranked above both halves) and adds
+//    the shortcuts that eliminating nodes in that order creates. It depends
+//    only on the road layout.
+//  - customize gives every arc the cheapest cost over the nodes ranked below
+//    both its ends (its lower triangles) for the current edge costs. After a
+//    few edge costs change, only the arcs depending on them are updated,
+//    lowest first. Each arc remembers the triangle its cost goes through,
+//    which also lets a path be unpacked without searching.
+//  - query climbs from both endpoints to the root of the elimination tree
+//    (each node's lowest higher neighbour) in rank order, so it touches a few
+//    hundred nodes however far apart the endpoints are, and stops relaxing
+//    from nodes already as far as the best meeting found.
+// Arcs join a lower-ranked node to a higher one and carry a cost each way;
+// all indices below are ranks unless named otherwise.
+class ContractionHierarchy {
+public:
+    static constexpr double kInfinity = numeric_limits<double>::infinity();
+
+private:
+    static const size_t kLeafSize = 16;   // Cells this small are not cut further
+
+    vector<int> rankOf, nodeAt;           // Node -> rank and back
+    vector<int> arcFirst;                 // Arcs of rank r: [arcFirst[r], arcFirst[r + 1]), by head
+    vector<int> arcTail, arcHead;         // Lower and higher end
+    vector<int> treeParent;               // Lowest higher neighbour, -1 at a root
+    vector<int> downFirst;                // Arcs reaching rank r from below: [downFirst[r], downFirst[r + 1])
+    vector<int> downArcs;                 // ... sorted by tail
+    vector<double> upCost, downCost;      // Customized cost tail -> head and head -> tail
+    vector<int> upMiddle, downMiddle;     // Lower triangle each cost goes through, -1 for an original edge
+    vector<char> pendingState;            // Scratch for customizeChanged, all zero between calls
+    vector<double> inputUp, inputDown;    // Cheapest original edge each way, or kInfinity
+    vector<int> edgeArc;                  // Arc of each original edge
+    vector<char> edgeUp;                  // Edge runs tail -> head
+    vector<int> arcEdgeFirst, arcEdges;   // Original edges of each arc
+    vector<double> edgeCost;
+    vector<int> changedArcs;              // Arcs whose edge costs changed since customize
+    vector<char> arcChanged;
+    bool customized = false;
+
+    // Per-query scratch, reset lazily by generation stamp
+    vector<double> forward, backward;
+    vector<int> forwardArc, backwardArc;  // Arc each search reached a rank by
+    vector<uint32_t> forwardStamp, backwardStamp;
+    uint32_t generation = 0;
+
+    // Arc from lower to higher, or -1
+    int findArc(int lower, int higher) const {
+        auto first = arcHead.begin() + arcFirst[lower], last = arcHead.begin() + arcFirst[lower + 1];
+        auto it = lower_bound(first, last, higher);
+        return it != last && *it == higher ? static_cast<int>(it - arcHead.begin()) : -1;
+    }
+
+    // Rank the nodes of cell from nextRank on: each half of a median cut
+    // first, then the nodes on the cut's smaller boundary. side[] is -1
+    // outside the cell on entry and on return.
+    void dissect(vector<int>& cell, const vector<pair<double, double>>& coordinates, const vector<int>& adjacencyFirst,
+                 const vector<int>& adjacency, vector<int>& side, int& nextRank) {
+        if (cell.size() <= kLeafSize) {
+            for (int v : cell) rankOf[v] = nextRank++;
             return;
         }
+        double minX = numeric_limits<double>::max(), maxX = -minX, minY = minX, maxY = -minX;
+        for (int v : cell) {
+            minX = min(minX, coordinates[v].first);
+            maxX = max(maxX, coordinates[v].first);
+            minY = min(minY, coordinates[v].second);
+            maxY = max(maxY, coordinates[v].second);
+        }
+        bool byX = maxX - minX >= maxY - minY;
+        auto key = [&](int v) { return byX ? coordinates[v].first : coordinates[v].second; };
+        size_t middle = cell.size() / 2;
+        nth_element(cell.begin(), cell.begin() + middle, cell.end(), [&](int a, int b) { return key(a) < key(b); });
+        // Cut at a coordinate so nodes on one grid line stay together, unless
+        // that leaves a half empty
+        double cut = key(cell[middle]);
+        size_t below = count_if(cell.begin(), cell.end(), [&](int v) { return key(v) < cut; });
+        for (size_t i = 0; i < cell.size(); i++) {
+            side[cell[i]] = below > 0 ? (key(cell[i]) < cut ? 0 : 1) : (i < middle ? 0 : 1);
+        }
 
-        int index = segmentMap[segmentID];
-        trafficData[index] = 0;
-        segmentMap.erase(segmentID);
-        sparseTable.buildSparseTable(trafficData);
-        cout << "Segment " << segmentID << " deleted successfully.\n";
+        vector<int> boundary[2];
+        for (int v : cell) {
+            for (int k = adjacencyFirst[v]; k < adjacencyFirst[v + 1]; k++) {
+                int w = adjacency[k];
+                if (side[w] >= 0 && side[w] != side[v]) {
+                    boundary[side[v]].push_back(v);
+                    break;
+                }
+            }
+        }
+        vector<int>& separator = boundary[0].size() <= boundary[1].size() ? boundary[0] : boundary[1];
+        for (int v : separator) side[v] = 2;
+        vector<int> halves[2];
+        for (int v : cell) {
+            if (side[v] < 2) halves[side[v]].push_back(v);
+        }
+        for (int v : cell) side[v] = -1;
+        vector<int>().swap(cell);
+
+        dissect(halves[0], coordinates, adjacencyFirst, adjacency, side, nextRank);
+        dissect(halves[1], coordinates, adjacencyFirst, adjacency, side, nextRank);
+        for (int v : separator) rankOf[v] = nextRank++;
     }
 
-    void updateTrafficData(const string& segmentID, int vehicleCount) {
-        if (segmentMap.find(segmentID) == segmentMap.end()) {
-            cout << "Segment not found. Add the segment first.\n";
+    // Cheapest cost of arc a each way, over its original edges and its
+    // lower triangles, with the triangle each goes through
+    void recompute(int a, double& up, double& down, int& upVia, int& downVia) const {
+        int u = arcTail[a], w = arcHead[a];
+        up = inputUp[a];
+        down = inputDown[a];
+        upVia = downVia = -1;
+        for (int k = downFirst[u]; k < downFirst[u + 1]; k++) {
+            int lowerU = downArcs[k], v = arcTail[lowerU];
+            int lowerW = findArc(v, w);
+            if (lowerW < 0) continue;
+            if (downCost[lowerU] + upCost[lowerW] < up) {     // u -> v -> w
+                up = downCost[lowerU] + upCost[lowerW];
+                upVia = v;
+            }
+            if (downCost[lowerW] + upCost[lowerU] < down) {   // w -> v -> u
+                down = downCost[lowerW] + upCost[lowerU];
+                downVia = v;
+            }
+        }
+    }
+
+    void customizeAll() {
+        upCost = inputUp;
+        downCost = inputDown;
+        upMiddle.assign(arcHead.size(), -1);
+        downMiddle.assign(arcHead.size(), -1);
+        // Ranks ascending: every arc of v already has its final cost
+        for (int v = 0; v + 1 < static_cast<int>(arcFirst.size()); v++) {
+            for (int i = arcFirst[v]; i < arcFirst[v + 1]; i++) {
+                int u = arcHead[i], b = arcFirst[u];
+                for (int j = i + 1; j < arcFirst[v + 1]; j++) {
+                    while (arcHead[b] < arcHead[j]) b++;   // Arc u -> head of j; chordality guarantees it
+                    if (downCost[i] + upCost[j] < upCost[b]) {
+                        upCost[b] = downCost[i] + upCost[j];
+                        upMiddle[b] = v;
+                    }
+                    if (downCost[j] + upCost[i] < downCost[b]) {
+                        downCost[b] = downCost[j] + upCost[i];
+                        downMiddle[b] = v;
+                    }
+                }
+            }
+        }
+    }
+
+    // Propagate the changed arcs upward, lowest tail first. When arc a of
+    // triangle {u, w, x} (u lowest) changes, the arc between w and x is
+    // lowered in place if the route through u got cheaper, and recomputed
+    // from all its lower triangles only if its cost went through u and that
+    // route got dearer.
+    void customizeChanged() {
+        enum { kLowered = 1, kRecompute = 2 };
+        typedef pair<int, int> Pending;   // (tail, arc)
+        priority_queue<Pending, vector<Pending>, greater<Pending>> pending;
+        pendingState.resize(arcHead.size(), 0);
+        auto mark = [&](int a, char state) {
+            if (!pendingState[a]) pending.push({arcTail[a], a});
+            pendingState[a] |= state;
+        };
+        for (int a : changedArcs) mark(a, kRecompute);
+        while (!pending.empty()) {
+            int a = pending.top().second;
+            pending.pop();
+            char state = pendingState[a];
+            pendingState[a] = 0;
+            if (state & kRecompute) {
+                double up, down;
+                recompute(a, up, down, upMiddle[a], downMiddle[a]);   // The middle may change on a tie
+                if (up == upCost[a] && down == downCost[a] && !(state & kLowered)) continue;
+                upCost[a] = up;
+                downCost[a] = down;
+            }
+            int u = arcTail[a], w = arcHead[a];
+            // Arcs of u are sorted by head and arcs into w by tail, so the arc
+            // c between w and each other neighbour x of u is found by merging
+            int below = downFirst[w], above = arcFirst[w];
+            for (int b = arcFirst[u]; b < arcFirst[u + 1]; b++) {
+                if (b == a) continue;
+                int x = arcHead[b], c;
+                double up, down;   // Costs of c through u each way
+                if (x < w) {
+                    while (arcTail[downArcs[below]] < x) below++;
+                    c = downArcs[below];
+                    up = downCost[b] + upCost[a];
+                    down = downCost[a] + upCost[b];
+                } else {
+                    while (arcHead[above] < x) above++;
+                    c = above;
+                    up = downCost[a] + upCost[b];
+                    down = downCost[b] + upCost[a];
+                }
+                if (up < upCost[c]) {
+                    upCost[c] = up;
+                    upMiddle[c] = u;
+                    mark(c, kLowered);
+                } else if (upMiddle[c] == u && up > upCost[c]) {
+                    mark(c, kRecompute);
+                }
+                if (down < downCost[c]) {
+                    downCost[c] = down;
+                    downMiddle[c] = u;
+                    mark(c, kLowered);
+                } else if (downMiddle[c] == u && down > downCost[c]) {
+                    mark(c, kRecompute);
+                }
+            }
+        }
+    }
+
+    // Append the nodes after the tail (upward) or head (downward) of arc a
+    // on the path it stands for
+    void unpack(int a, bool upward, vector<int>& path) const {
+        int v = upward ? upMiddle[a] : downMiddle[a];
+        if (v < 0) {
+            path.push_back(nodeAt[upward ? arcHead[a] : arcTail[a]]);
             return;
         }
+        int lowerU = findArc(v, arcTail[a]), lowerW = findArc(v, arcHead[a]);
+        if (upward) {
+            unpack(lowerU, false, path);
+            unpack(lowerW, true, path);
+        } else {
+            unpack(lowerW, false, path);
+            unpack(lowerU, true, path);
+        }
+    }
 
-        int index = segmentMap[segmentID];
-        trafficData[index] = vehicleCount;
-        sparseTable.buildSparseTable(trafficData);
-        cout << "Traffic data for segment " << segmentID << " updated to " << vehicleCount << " vehicles.\n";
+public:
+    // Build for nodes at the given coordinates and directed edges in CSR
+    // form (edges of node v are [offsets[v], offsets[v + 1]), to targets[e]).
+    // Every edge costs kInfinity until setEdgeCost.
+    void build(const vector<pair<double, double>>& coordinates, const vector<int>& offsets, const vector<int>& targets) {
+        int n = static_cast<int>(coordinates.size());
+
+        // Undirected adjacency for the cuts
+        vector<int> adjacencyFirst(n + 1, 0), adjacency(2 * targets.size());
+        for (int v = 0; v < n; v++) {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                adjacencyFirst[v + 1]++;
+                adjacencyFirst[targets[e] + 1]++;
+            }
+        }
+        for (int v = 0; v < n; v++) adjacencyFirst[v + 1] += adjacencyFirst[v];
+        vector<int> next(adjacencyFirst.begin(), adjacencyFirst.end() - 1);
+        for (int v = 0; v < n; v++) {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                adjacency[next[v]++] = targets[e];
+                adjacency[next[targets[e]]++] = v;
+            }
+        }
+
+        rankOf.assign(n, -1);
+        vector<int> cell(n), side(n, -1);
+        iota(cell.begin(), cell.end(), 0);
+        int nextRank = 0;
+        dissect(cell, coordinates, adjacencyFirst, adjacency, side, nextRank);
+        nodeAt.assign(n, 0);
+        for (int v = 0; v < n; v++) nodeAt[rankOf[v]] = v;
+
+        // Eliminate ranks in order: the higher neighbours of each rank
+        // become neighbours of its lowest higher neighbour
+        vector<vector<int>> upper(n);
+        for (int v = 0; v < n; v++) {
+            for (int k = adjacencyFirst[v]; k < adjacencyFirst[v + 1]; k++) {
+                int a = rankOf[v], b = rankOf[adjacency[k]];
+                if (a < b) upper[a].push_back(b);
+            }
+        }
+        for (int r = 0; r < n; r++) {
+            sort(upper[r].begin(), upper[r].end());
+            upper[r].erase(unique(upper[r].begin(), upper[r].end()), upper[r].end());
+            if (upper[r].size() < 2) continue;
+            vector<int>& parentUpper = upper[upper[r][0]];
+            vector<int> merged;
+            set_union(parentUpper.begin(), parentUpper.end(), upper[r].begin() + 1, upper[r].end(), back_inserter(merged));
+            parentUpper.swap(merged);
+        }
+
+        arcFirst.assign(n + 1, 0);
+        treeParent.assign(n, -1);
+        for (int r = 0; r < n; r++) {
+            arcFirst[r + 1] = arcFirst[r] + static_cast<int>(upper[r].size());
+            if (!upper[r].empty()) treeParent[r] = upper[r][0];
+        }
+        size_t numArcs = arcFirst[n];
+        arcTail.resize(numArcs);
+        arcHead.resize(numArcs);
+        downFirst.assign(n + 1, 0);
+        for (int r = 0; r < n; r++) {
+            copy(upper[r].begin(), upper[r].end(), arcHead.begin() + arcFirst[r]);
+            fill(arcTail.begin() + arcFirst[r], arcTail.begin() + arcFirst[r + 1], r);
+            for (int w : upper[r]) downFirst[w + 1]++;
+            vector<int>().swap(upper[r]);
+        }
+        for (int r = 0; r < n; r++) downFirst[r + 1] += downFirst[r];
+        downArcs.resize(numArcs);
+        next.assign(downFirst.begin(), downFirst.end() - 1);
+        for (size_t a = 0; a < numArcs; a++) downArcs[next[arcHead[a]]++] = static_cast<int>(a);   // Tails ascending
+
+        size_t numEdges = targets.size();
+        edgeArc.resize(numEdges);
+        edgeUp.resize(numEdges);
+        arcEdgeFirst.assign(numArcs + 1, 0);
+        for (int v = 0; v < n; v++) {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                int a = rankOf[v], b = rankOf[targets[e]];
+                edgeUp[e] = a < b;
+                edgeArc[e] = a < b ? findArc(a, b) : findArc(b, a);
+                arcEdgeFirst[edgeArc[e] + 1]++;
+            }
+        }
+        for (size_t a = 0; a < numArcs; a++) arcEdgeFirst[a + 1] += arcEdgeFirst[a];
+        arcEdges.resize(numEdges);
+        next.assign(arcEdgeFirst.begin(), arcEdgeFirst.end() - 1);
+        for (size_t e = 0; e < numEdges; e++) arcEdges[next[edgeArc[e]]++] = static_cast<int>(e);
+
+        edgeCost.assign(numEdges, kInfinity);
+        inputUp.assign(numArcs, kInfinity);
+        inputDown.assign(numArcs, kInfinity);
+        arcChanged.assign(numArcs, 0);
+        changedArcs.clear();
+        customized = false;
+
+        forward.assign(n, 0);
+        backward.assign(n, 0);
+        forwardArc.assign(n, -1);
+        backwardArc.assign(n, -1);
+        forwardStamp.assign(n, 0);
+        backwardStamp.assign(n, 0);
+        generation = 0;
     }
 
-    int getTrafficData(const string& segmentID) const {
-        if (segmentMap.find(segmentID) == segmentMap.end()) {
-            cout << "No data found for segment ID: " << segmentID << endl;
-            return -1;
+    size_t arcCount() const { return arcHead.size(); }
+
+    // Set the cost of original edge e; applied by the next customize()
+    void setEdgeCost(int e, double cost) {
+        if (cost == edgeCost[e]) return;
+        edgeCost[e] = cost;
+        int a = edgeArc[e];
+        if (!arcChanged[a]) {
+            arcChanged[a] = 1;
+            changedArcs.push_back(a);
         }
-        return trafficData[segmentMap.at(segmentID)];
     }
 
-    int queryMaxTraffic(int L, int R) {
-        return sparseTable.queryMax(L, R);
+    // Bring arc costs up to date with the edge costs set since the last call.
+    // The first call, and any that changes more than 1 in 8 arcs, sweeps
+    // every lower triangle; otherwise only affected arcs are recomputed.
+    void customize() {
+        if (customized && changedArcs.empty()) return;
+        for (int a : changedArcs) {
+            inputUp[a] = inputDown[a] = kInfinity;
+            for (int k = arcEdgeFirst[a]; k < arcEdgeFirst[a + 1]; k++) {
+                int e = arcEdges[k];
+                double& input = edgeUp[e] ? inputUp[a] : inputDown[a];
+                input = min(input, edgeCost[e]);
+            }
+            arcChanged[a] = 0;
+        }
+        if (!customized || changedArcs.size() * 8 > arcHead.size()) {
+            customizeAll();
+        } else {
+            customizeChanged();
+        }
+        changedArcs.clear();
+        customized = true;
     }
 
-    int queryMinTraffic(int L, int R) {
-        return sparseTable.queryMin(L, R);
+    // Cheapest cost from source to target (node IDs), or kInfinity if
+    // unreachable; path gets the nodes on the way. Costs must be customized.
+    double query(int source, int target, vector<int>& path) {
+        path.clear();
+        if (++generation == 0) {
+            fill(forwardStamp.begin(), forwardStamp.end(), 0);
+            fill(backwardStamp.begin(), backwardStamp.end(), 0);
+            generation = 1;
+        }
+        double best = kInfinity;
+        int meet = -1;
+        // Relax the arcs of x unless its distance already reaches best: no
+        // route through x's higher neighbours could then be cheaper
+        auto relax = [&](int x, vector<double>& distance, vector<int>& via, vector<uint32_t>& stamp,
+                         const vector<double>& cost) {
+            if (stamp[x] != generation || distance[x] >= best) return;
+            for (int a = arcFirst[x]; a < arcFirst[x + 1]; a++) {
+                int y = arcHead[a];
+                double candidate = distance[x] + cost[a];
+                if (stamp[y] != generation || candidate < distance[y]) {
+                    stamp[y] = generation;
+                    distance[y] = candidate;
+                    via[y] = a;
+                }
+            }
+        };
+        int s = rankOf[source], t = rankOf[target];
+        forward[s] = backward[t] = 0;
+        forwardArc[s] = backwardArc[t] = -1;
+        forwardStamp[s] = backwardStamp[t] = generation;
+        // Climb both chains together in rank order, so a node both reach is
+        // final on both sides when it is visited
+        for (int x = s, y = t; x != -1 || y != -1;) {
+            if (x == y) {
+                if (forwardStamp[x] == generation && backwardStamp[x] == generation && forward[x] + backward[x] < best) {
+                    best = forward[x] + backward[x];
+                    meet = x;
+                }
+                relax(x, forward, forwardArc, forwardStamp, upCost);
+                relax(x, backward, backwardArc, backwardStamp, downCost);
+                x = y = treeParent[x];
+            } else if (y == -1 || (x != -1 && x < y)) {
+                relax(x, forward, forwardArc, forwardStamp, upCost);
+                x = treeParent[x];
+            } else {
+                relax(y, backward, backwardArc, backwardStamp, downCost);
+                y = treeParent[y];
+            }
+        }
+        if (meet < 0) return kInfinity;
+
+        vector<int> up;
+        for (int x = meet; forwardArc[x] != -1; x = arcTail[forwardArc[x]]) up.push_back(forwardArc[x]);
+        path.push_back(source);
+        for (auto it = up.rbegin(); it != up.rend(); ++it) unpack(*it, true, path);
+        for (int x = meet; backwardArc[x] != -1; x = arcTail[backwardArc[x]]) unpack(backwardArc[x], false, path);
+        return best;
     }
+};
 
-    double queryAverageTraffic(int L, int R) {
-        if (L < 1 || R > trafficData.size() || L > R) {
-            cout << "Invalid range query.\n";
-            return -1;
+// Road network for congestion-aware routing. Intersections are nodes and
+// each direction of a road segment is an edge, stored in CSR form (one
+// offset per node into flat target/length/segment arrays). route() answers
+// from a ContractionHierarchy built once per road layout; edge costs are
+// read from TrafficMonitor when its counts changed since the last query, and
+// only the shortcuts depending on changed edges are recomputed.
+class RoadGraph {
+public:
+    // Every extra kCongestionVehicles vehicles on a segment add its free-flow
+    // travel cost again. Costs never drop below length, which keeps the
+    // straight-line A* heuristic admissible.
+    static constexpr double kCongestionVehicles = 50.0;
+
+private:
+    struct Road {
+        int from, to;
+        double length;
+        string segmentID;   // Kept by ID: handles die with their segment
+    };
+
+    vector<pair<double, double>> coordinates;   // Per intersection, in km
+    vector<Road> roads;                         // Edge list; CSR is derived from it
+    vector<int> offsets;                        // Edges of node v: [offsets[v], offsets[v + 1])
+    vector<int> targets;
+    vector<double> lengths;
+    vector<int> edgeRoads;                      // Road each CSR edge came from
+    vector<SegmentHandle> segments;             // Resolved from edgeRoads at resolvedVersion
+    vector<int> segmentEdgeFirst;               // Edges on handle h: segmentEdges[segmentEdgeFirst[h]...]
+    vector<int> segmentEdges;
+    uint64_t resolvedVersion = 0;
+    bool dirty = false;
+
+    ContractionHierarchy hierarchy;             // Built with the CSR
+    bool costsCurrent = false;                  // Hierarchy holds the costs at costsCountVersion
+    uint64_t costsCountVersion = 0;
+
+    // Per-query scratch, reset lazily by generation stamp
+    vector<double> distance;
+    vector<int> parent;
+    vector<uint32_t> stamp;       // stamp[v] == generation: distance[v] is set
+    vector<uint32_t> settled;     // settled[v] == generation: v was finalized
+    uint32_t generation = 0;
+
+    void buildCSR() {
+        size_t n = coordinates.size();
+        offsets.assign(n + 1, 0);
+        for (const Road& road : roads) offsets[road.from + 1]++;
+        for (size_t v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+        targets.resize(roads.size());
+        lengths.resize(roads.size());
+        edgeRoads.resize(roads.size());
+        segments.resize(roads.size());
+        vector<int> next(offsets.begin(), offsets.end() - 1);
+        for (size_t r = 0; r < roads.size(); r++) {
+            int e = next[roads[r].from]++;
+            targets[e] = roads[r].to;
+            lengths[e] = roads[r].length;
+            edgeRoads[e] = static_cast<int>(r);
         }
-        return accumulate(trafficData.begin() + (L - 1), trafficData.begin() + R, 0.0) / (R - L + 1);
+        distance.assign(n, 0);
+        parent.assign(n, -1);
+        stamp.assign(n, 0);
+        settled.assign(n, 0);
+        generation = 0;
+        hierarchy.build(coordinates, offsets, targets);
+        costsCurrent = false;
+        dirty = false;
     }
 
-    int queryTotalTraffic() {
-        return accumulate(trafficData.begin(), trafficData.end(), 0);
+    // Look up every edge's segment handle again. Runs after the CSR is
+    // rebuilt and whenever the monitor's segments changed since the last
+    // lookup, so a deleted segment's reused handle is never followed.
+    void resolveSegments(const TrafficMonitor& monitor) {
+        size_t handles = 0;
+        for (size_t e = 0; e < segments.size(); e++) {
+            segments[e] = monitor.findSegment(roads[edgeRoads[e]].segmentID);
+            if (segments[e] != kInvalidSegment) handles = max<size_t>(handles, segments[e] + 1);
+        }
+        segmentEdgeFirst.assign(handles + 1, 0);
+        for (SegmentHandle h : segments) {
+            if (h != kInvalidSegment) segmentEdgeFirst[h + 1]++;
+        }
+        for (size_t h = 0; h < handles; h++) segmentEdgeFirst[h + 1] += segmentEdgeFirst[h];
+        segmentEdges.resize(segmentEdgeFirst[handles]);
+        vector<int> next(segmentEdgeFirst.begin(), segmentEdgeFirst.end() - 1);
+        for (size_t e = 0; e < segments.size(); e++) {
+            if (segments[e] != kInvalidSegment) segmentEdges[next[segments[e]]++] = static_cast<int>(e);
+        }
+        resolvedVersion = monitor.segmentVersion();
+        costsCurrent = false;
     }
 
-    void displayRankedSegments() const {
-        vector<pair<string, int>> rankedSegments;
-        for (const auto& entry : segmentMap) {
-            rankedSegments.emplace_back(entry.first, trafficData[entry.second]);
+    // Rebuild what the road layout or the monitor's segments invalidated
+    void prepare(const TrafficMonitor& monitor) {
+        if (dirty) {
+            buildCSR();
+            resolveSegments(monitor);
+        } else if (resolvedVersion != monitor.segmentVersion()) {
+            resolveSegments(monitor);
         }
-        sort(rankedSegments.begin(), rankedSegments.end(), [](const auto& a, const auto& b) {
-            return a.second > b.second;
-        });
+    }
 
-        cout << "Segments ranked by traffic:\n";
-        for (const auto& segment : rankedSegments) {
-            cout << segment.first << ": " << segment.second << " vehicles\n";
+    double straightLine(int a, int b) const {
+        return hypot(coordinates[a].first - coordinates[b].first, coordinates[a].second - coordinates[b].second);
+    }
+
+public:
+    int addIntersection(double x, double y) {
+        coordinates.emplace_back(x, y);
+        dirty = true;
+        return static_cast<int>(coordinates.size()) - 1;
+    }
+
+    // Add a road carrying the given segment's traffic; both directions unless oneWay.
+    // Lengths below the straight-line distance are raised to it.
+    bool addRoad(int from, int to, double length, const string& segmentID, bool oneWay = false) {
+        int n = static_cast<int>(coordinates.size());
+        if (from < 0 || from >= n || to < 0 || to >= n || from == to) return false;
+        length = max(length, straightLine(from, to));
+        roads.push_back({from, to, length, segmentID});
+        if (!oneWay) roads.push_back({to, from, length, segmentID});
+        dirty = true;
+        return true;
+    }
+
+    int intersectionCount() const { return static_cast<int>(coordinates.size()); }
+
+    // Current cost of travelling an edge of the given length on a segment.
+    // A segment that no longer exists (kInvalidSegment) has unknown traffic
+    // and costs its free-flow length.
+    static double travelCost(const TrafficMonitor& monitor, SegmentHandle segment, double length) {
+        int vehicles = max(monitor.getTrafficData(segment), 0);
+        return length * (1.0 + vehicles / kCongestionVehicles);
+    }
+
+    // Bring the hierarchy up to date with the road layout and traffic. The
+    // first call after the layout changed builds it; after traffic changed,
+    // only the edges of segments whose counts changed are priced again (all
+    // of them if the monitor no longer lists that many) and only the arcs
+    // those edges affect are customized. route() calls this itself; calling
+    // it after a batch of updates keeps that work out of the next query.
+    void refreshCosts(const TrafficMonitor& monitor) {
+        prepare(monitor);
+        vector<SegmentHandle> changed;
+        if (costsCurrent && monitor.countChangesSince(costsCountVersion, changed)) {
+            for (SegmentHandle h : changed) {
+                if (h + 1 >= segmentEdgeFirst.size()) continue;   // No road carries it
+                for (int k = segmentEdgeFirst[h]; k < segmentEdgeFirst[h + 1]; k++) {
+                    int e = segmentEdges[k];
+                    hierarchy.setEdgeCost(e, travelCost(monitor, segments[e], lengths[e]));
+                }
+            }
+            costsCountVersion = monitor.countVersion();
+        } else if (!costsCurrent || costsCountVersion != monitor.countVersion()) {
+            for (size_t e = 0; e < targets.size(); e++) {
+                hierarchy.setEdgeCost(static_cast<int>(e), travelCost(monitor, segments[e], lengths[e]));
+            }
+            costsCurrent = true;
+            costsCountVersion = monitor.countVersion();
         }
+        hierarchy.customize();
     }
 
-    void displayTrafficData() const {
-        cout << "Traffic Data for each Road Segment:\n";
-        for (const auto& entry : segmentMap) {
-            cout << "Segment ID " << entry.first << ": " << trafficData[entry.second] << " vehicles\n";
+    // Cheapest route from source to target under current traffic. Returns
+    // the cost (or -1 if unreachable) and fills path with the intersections.
+    double route(const TrafficMonitor& monitor, int source, int target, vector<int>& path) {
+        path.clear();
+        int n = intersectionCount();
+        if (source < 0 || source >= n || target < 0 || target >= n) return -1;
+        refreshCosts(monitor);
+        double cost = hierarchy.query(source, target, path);
+        return cost == ContractionHierarchy::kInfinity ? -1 : cost;
+    }
+
+    // Same answer as route() by a direct search over the CSR, with no
+    // preprocessing. A* uses straight-line distance as its heuristic;
+    // without it this is plain Dijkstra. Both stop as soon as target is
+    // settled. Kept as the reference route() is checked against.
+    double searchRoute(const TrafficMonitor& monitor, int source, int target, vector<int>& path, bool useAStar = true) {
+        path.clear();
+        int n = intersectionCount();
+        if (source < 0 || source >= n || target < 0 || target >= n) return -1;
+        prepare(monitor);
+        if (++generation == 0) {
+            fill(stamp.begin(), stamp.end(), 0);
+            fill(settled.begin(), settled.end(), 0);
+            generation = 1;
+        }
+
+        auto estimate = [&](int v) { return useAStar ? straightLine(v, target) : 0.0; };
+        typedef pair<double, int> QueueEntry;   // (distance + estimate, node)
+        priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> frontier;
+        distance[source] = 0;
+        parent[source] = -1;
+        stamp[source] = generation;
+        frontier.push({estimate(source), source});
+
+        while (!frontier.empty()) {
+            QueueEntry top = frontier.top();
+            frontier.pop();
+            int v = top.second;
+            if (settled[v] == generation) continue;   // Stale entry
+            settled[v] = generation;
+            if (v == target) break;
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                int w = targets[e];
+                if (settled[w] == generation) continue;
+                double candidate = distance[v] + travelCost(monitor, segments[e], lengths[e]);
+                if (stamp[w] != generation || candidate < distance[w]) {
+                    stamp[w] = generation;
+                    distance[w] = candidate;
+                    parent[w] = v;
+                    frontier.push({candidate + estimate(w), w});
+                }
+            }
         }
+
+        if (stamp[target] != generation) return -1;
+        for (int v = target; v != -1; v = parent[v]) path.push_back(v);
+        reverse(path.begin(), path.end());
+        return distance[target];
     }
 };
 
+// Routing benchmark on a side x side grid of two-way roads 100 m apart,
+// one segment per road with random traffic. Queries run corner region to
+// corner region across the city; before each, updatesPerQuery random
+// segments get new counts. Every route() answer is checked against A* and
+// the latency of both is reported.
+int runRouteBenchmark(int side, int queries, int updatesPerQuery) {
+    if (side < 2 || queries < 1 || updatesPerQuery < 0) {
+        cerr << "Need a grid side of at least 2 and a positive query count.\n";
+        return 1;
+    }
+    mt19937 rng(1);
+    RoadGraph roads;
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) roads.addIntersection(x * 0.1, y * 0.1);
+    }
+    int numRoads = 2 * side * (side - 1);
+    TrafficMonitor monitor(numRoads);
+    vector<SegmentHandle> handles;
+    auto addRoad = [&](int from, int to) {
+        string segmentID = "R" + to_string(handles.size() + 1);
+        handles.push_back(monitor.registerSegment(segmentID));
+        monitor.updateTrafficData(handles.back(), (int)(rng() % 200));
+        roads.addRoad(from, to, 0.1 * (1 + (rng() % 30) / 100.0), segmentID);
+    };
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            if (x + 1 < side) addRoad(y * side + x, y * side + x + 1);
+            if (y + 1 < side) addRoad(y * side + x, (y + 1) * side + x);
+        }
+    }
+
+    vector<int> path;
+    auto start = chrono::steady_clock::now();
+    roads.refreshCosts(monitor);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << side * side << " intersections, " << numRoads << " roads: hierarchy built and customized in "
+         << buildMs << " ms\n";
+
+    int region = max(1, side / 10);
+    auto corner = [&](bool far) {
+        int x = (int)(rng() % region), y = (int)(rng() % region);
+        return far ? (side - 1 - y) * side + (side - 1 - x) : y * side + x;
+    };
+    vector<double> customizeUs, hierarchyUs, searchUs;
+    int mismatches = 0;
+    for (int q = 0; q < queries; q++) {
+        for (int u = 0; u < updatesPerQuery; u++) {
+            monitor.updateTrafficData(handles[rng() % handles.size()], (int)(rng() % 200));
+        }
+        start = chrono::steady_clock::now();
+        roads.refreshCosts(monitor);
+        customizeUs.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        int source = corner(false), target = corner(true);
+        start = chrono::steady_clock::now();
+        double cost = roads.route(monitor, source, target, path);
+        hierarchyUs.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        vector<int> expectedPath;
+        start = chrono::steady_clock::now();
+        double expected = roads.searchRoute(monitor, source, target, expectedPath);
+        searchUs.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        if (fabs(cost - expected) > 1e-9 * max(1.0, expected) || path.front() != source || path.back() != target) {
+            if (mismatches++ == 0) {
+                cout << "MISMATCH from " << source << " to " << target << ": route " << cost << ", A* " << expected << "\n";
+            }
+        }
+    }
+
+    auto report = [&](const string& name, vector<double>& us) {
+        sort(us.begin(), us.end());
+        double total = accumulate(us.begin(), us.end(), 0.0);
+        cout << name << ": mean " << total / us.size() << " us, median " << us[us.size() / 2] << " us, p99 "
+             << us[min(us.size() - 1, us.size() * 99 / 100)] << " us\n";
+    };
+    cout << queries << " cross-city queries, " << updatesPerQuery << " traffic updates before each:\n";
+    if (updatesPerQuery > 0) report("  customize after the updates", customizeUs);
+    report("  route (hierarchy)", hierarchyUs);
+    report("  A* search", searchUs);
+    cout << (mismatches ? to_string(mismatches) + " answers differ from A*" : "every answer matches A*") << "\n";
+    return mismatches ? 1 : 0;
+}
+
 void displayMenu() {
     cout << "\nMenu:\n";
     cout << "1. Add road segment\n";
@@ -171,16 +2722,74 @@ void displayMenu() {
     cout << "8. Query average traffic in a range\n";
     cout << "9. Query total traffic count\n";
     cout << "10. Display ranked segments\n";
-    cout << "11. Exit\n";
+    cout << "11. Query maximum traffic for multiple ranges\n";
+    cout << "12. Subscribe to congestion alerts for a range\n";
+    cout << "13. Cancel a congestion alert subscription\n";
+    cout << "14. Show pending congestion alerts\n";
+    cout << "15. Show busiest segments in the last hour (approximate)\n";
+    cout << "16. Record a vehicle sighting\n";
+    cout << "17. Estimate distinct vehicles seen in the last hour\n";
+    cout << "18. Add intersection\n";
+    cout << "19. Add road between intersections\n";
+    cout << "20. Find fastest route\n";
+    cout << "21. Exit\n";
     cout << "Enter your choice: ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes (an endpoint is a Unix socket path or host:port):
+    //   --serve <endpoint> <segments> [linear]
+    //   --loadgen <endpoint> <connections> <seconds> <depth> <segments>
+    //   --shard-demo <shards> <segments per shard>
+    //   --generate <trace> <operations> <segments> [seed]
+    //   --replay <trace>
+    //   --route-bench <grid side> <queries> [updates per query]
+    if (argc >= 4 && string(argv[1]) == "--serve") {
+        int segments = atoi(argv[3]);
+        if (segments < 1) {
+            cerr << "Segment count must be positive.\n";
+            return 1;
+        }
+        TrafficMonitor monitor(segments, argc >= 5 && string(argv[4]) == "linear");
+        for (int i = 1; i <= segments; i++) monitor.registerSegment("S" + to_string(i));
+        return runTrafficServer(argv[2], monitor);
+    }
+    if (argc >= 7 && string(argv[1]) == "--loadgen") {
+        return runTrafficLoadGenerator(argv[2], atoi(argv[3]), atoi(argv[4]), atoi(argv[5]), atoi(argv[6]));
+    }
+    if (argc >= 4 && string(argv[1]) == "--shard-demo") {
+        return runShardDemo(atoi(argv[2]), atoi(argv[3]));
+    }
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        int segments = atoi(argv[4]);
+        if (segments < 1) {
+            cerr << "Segment count must be positive.\n";
+            return 1;
+        }
+        if (!generateTrafficTrace(argv[2], atoll(argv[3]), segments, argc >= 6 ? (unsigned)atoi(argv[5]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayTrafficTrace(argv[2]);
+    }
+    if (argc >= 4 && string(argv[1]) == "--route-bench") {
+        return runRouteBenchmark(atoi(argv[2]), atoi(argv[3]), argc >= 5 ? atoi(argv[4]) : 0);
+    }
+
     int numSegments;
-    cout << "Enter the total number of road segments: ";
+    cout << "Enter the expected number of road segments: ";
     cin >> numSegments;
 
-    TrafficMonitor monitor(numSegments);
+    char mode;
+    cout << "Use linear-space range queries for large networks? (y/n): ";
+    cin >> mode;
+
+    TrafficMonitor monitor(numSegments, mode == 'y' || mode == 'Y');
+    monitor.enableSketches();
+    RoadGraph roads;
     int choice;
 
     do {
@@ -252,13 +2861,135 @@ int main() {
         case 10:
             monitor.displayRankedSegments();
             break;
-        case 11:
+        case 11: {
+            int count;
+            cout << "Enter the number of ranges: ";
+            cin >> count;
+            vector<pair<int, int>> ranges(max(count, 0));
+            cout << "Enter each range as L R:\n";
+            for (auto& range : ranges) {
+                cin >> range.first >> range.second;
+            }
+            vector<int> results = monitor.queryMaxTrafficBatch(ranges);
+            for (size_t i = 0; i < ranges.size(); i++) {
+                if (results[i] == -1) {
+                    cout << "Range " << ranges[i].first << "-" << ranges[i].second << ": Invalid range query.\n";
+                } else {
+                    cout << "Range " << ranges[i].first << "-" << ranges[i].second
+                         << ": Maximum traffic " << results[i] << endl;
+                }
+            }
+            break;
+        }
+        case 12: {
+            int L, R, threshold;
+            cout << "Enter range (L R) and congestion threshold: ";
+            cin >> L >> R >> threshold;
+            int id = monitor.subscribeCongestion(L, R, threshold);
+            if (id == -1) {
+                cout << "Invalid range query.\n";
+            } else {
+                cout << "Subscription " << id << " created.\n";
+            }
+            break;
+        }
+        case 13: {
+            int id;
+            cout << "Enter subscription ID to cancel: ";
+            cin >> id;
+            cout << (monitor.unsubscribeCongestion(id) ? "Subscription cancelled.\n" : "Subscription not found.\n");
+            break;
+        }
+        case 14: {
+            CongestionAlert alert;
+            int shown = 0;
+            while (monitor.pollCongestionAlert(alert)) {
+                cout << "Subscription " << alert.subscriptionID << ": "
+                     << (alert.congested ? "congested" : "cleared") << " (segment position " << alert.position
+                     << ", range max " << alert.rangeMax << ")\n";
+                shown++;
+            }
+            if (shown == 0) cout << "No pending congestion alerts.\n";
+            if (monitor.droppedCongestionAlerts() > 0) {
+                cout << monitor.droppedCongestionAlerts() << " alerts were dropped because the queue was full.\n";
+            }
+            break;
+        }
+        case 15: {
+            int k;
+            cout << "Enter number of segments to show: ";
+            cin >> k;
+            vector<TrafficSketches::BusySegment> busiest = monitor.trafficSketches()->busiest(max(k, 0));
+            if (busiest.empty()) cout << "No traffic recorded in the last hour.\n";
+            for (const auto& segment : busiest) {
+                cout << segment.segmentID << ": about " << segment.volume << " vehicle-minutes (error at most "
+                     << segment.error << ")\n";
+            }
+            break;
+        }
+        case 16: {
+            string vehicleID;
+            cout << "Enter vehicle ID: ";
+            cin >> vehicleID;
+            monitor.recordVehicle(vehicleID);
+            cout << "Vehicle sighting recorded.\n";
+            break;
+        }
+        case 17:
+            cout << "Distinct vehicles seen in the last hour: about "
+                 << llround(monitor.trafficSketches()->estimatedDistinctVehicles()) << endl;
+            break;
+        case 18: {
+            double x, y;
+            cout << "Enter intersection coordinates in km (x y): ";
+            cin >> x >> y;
+            cout << "Intersection " << roads.addIntersection(x, y) << " added.\n";
+            break;
+        }
+        case 19: {
+            int from, to;
+            double length;
+            string segmentID;
+            char oneWay;
+            cout << "Enter intersections to connect (from to): ";
+            cin >> from >> to;
+            cout << "Enter road segment ID carrying this road: ";
+            cin >> segmentID;
+            cout << "Enter road length in km: ";
+            cin >> length;
+            cout << "One-way? (y/n): ";
+            cin >> oneWay;
+            if (monitor.findSegment(segmentID) == kInvalidSegment) {
+                cout << "Segment not found. Add the segment first.\n";
+            } else if (roads.addRoad(from, to, length, segmentID, oneWay == 'y' || oneWay == 'Y')) {
+                cout << "Road added on segment " << segmentID << ".\n";
+            } else {
+                cout << "Invalid intersections.\n";
+            }
+            break;
+        }
+        case 20: {
+            int from, to;
+            cout << "Enter start and destination intersections: ";
+            cin >> from >> to;
+            vector<int> path;
+            double cost = roads.route(monitor, from, to, path);
+            if (cost < 0) {
+                cout << "No route found.\n";
+            } else {
+                cout << "Fastest route (cost " << cost << "):";
+                for (int v : path) cout << " " << v;
+                cout << endl;
+            }
+            break;
+        }
+        case 21:
             cout << "Exiting...\n";
             break;
         default:
-            cout << "Invalid choice. Please enter a number between 1 and 11.\n";
+            cout << "Invalid choice. Please enter a number between 1 and 21.\n";
         }
-    } while (choice != 11);
+    } while (choice != 21);
 
     return 0;
 }
@@ -1,15 +1,312 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
 #include <algorithm>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>  // AVX2 / AVX-512 scan kernels, enabled per function
+#endif
+
+#include "segment_id_interner.h"
+#include "trace_harness.h"
+
 using namespace std;
 
+// Sum, max and min of a scan, with the first index holding each extreme
+struct ScanSummary {
+    long long total;
+    int maxValue;
+    size_t maxIndex;
+    int minValue;
+    size_t minIndex;
+};
+
+// Scan kernels over a dense array of vehicle counts. Each instruction set
+// provides the same primitives; the widest one the CPU supports is picked
+// once at runtime, so unindexed full-network scans run at memory bandwidth.
+struct ScanKernels {
+    const char* name;
+    // Sum, max, min and the first index of each extreme in a single pass (n >= 1)
+    void (*summarize)(const int* data, size_t n, ScanSummary& summary);
+    // counts[k] = number of elements greater than thresholds[k]
+    void (*countGreater)(const int* data, size_t n, const int* thresholds, size_t numThresholds, size_t* counts);
+};
+
+// Fold in the summary of the positions starting at offset. Ties keep the
+// earlier index, so summary must already cover every position before offset.
+void mergeSummary(ScanSummary& summary, const ScanSummary& part, size_t offset) {
+    summary.total += part.total;
+    if (part.maxValue > summary.maxValue) {
+        summary.maxValue = part.maxValue;
+        summary.maxIndex = part.maxIndex + offset;
+    }
+    if (part.minValue < summary.minValue) {
+        summary.minValue = part.minValue;
+        summary.minIndex = part.minIndex + offset;
+    }
+}
+
+// Scalar pass over data[begin, n), continuing a summary of data[0, begin)
+void scalarSummarizeFrom(const int* data, size_t begin, size_t n, ScanSummary& summary) {
+    for (size_t i = begin; i < n; i++) {
+        summary.total += data[i];
+        if (data[i] > summary.maxValue) {
+            summary.maxValue = data[i];
+            summary.maxIndex = i;
+        }
+        if (data[i] < summary.minValue) {
+            summary.minValue = data[i];
+            summary.minIndex = i;
+        }
+    }
+}
+
+void scalarSummarize(const int* data, size_t n, ScanSummary& summary) {
+    summary = {0, numeric_limits<int>::min(), 0, numeric_limits<int>::max(), 0};
+    scalarSummarizeFrom(data, 0, n, summary);
+}
+
+void scalarCountGreater(const int* data, size_t n, const int* thresholds, size_t numThresholds, size_t* counts) {
+    for (size_t k = 0; k < numThresholds; k++) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) count += data[i] > thresholds[k];
+        counts[k] = count;
+    }
+}
+
+const ScanKernels scalarKernels = {
+    "scalar", scalarSummarize, scalarCountGreater
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRAFFIC_X86_KERNELS 1
+
+// Per-lane 32-bit counters are flushed after this many vectors so they cannot overflow
+const size_t kCounterFlushVectors = size_t(1) << 28;
+
+// Vector lanes track positions as 32-bit indices, so long scans are
+// summarized in windows of this many elements and merged
+const size_t kIndexWindow = size_t(1) << 30;
+
+template <typename WindowKernel>
+void summarizeInWindows(WindowKernel window, const int* data, size_t n, ScanSummary& summary) {
+    window(data, min(n, kIndexWindow), summary);
+    for (size_t offset = kIndexWindow; offset < n; offset += kIndexWindow) {
+        ScanSummary part;
+        window(data + offset, min(n - offset, kIndexWindow), part);
+        mergeSummary(summary, part, offset);
+    }
+}
+
+// Combine per-lane extremes: the best value wins, equal values keep the earlier index
+void reduceLanes(const int* maxLanes, const int* maxIndexLanes, const int* minLanes, const int* minIndexLanes,
+                 size_t numLanes, ScanSummary& summary) {
+    summary.maxValue = numeric_limits<int>::min();
+    summary.minValue = numeric_limits<int>::max();
+    summary.maxIndex = summary.minIndex = 0;
+    for (size_t k = 0; k < numLanes; k++) {
+        size_t maxIndex = static_cast<unsigned>(maxIndexLanes[k]), minIndex = static_cast<unsigned>(minIndexLanes[k]);
+        if (maxLanes[k] > summary.maxValue || (maxLanes[k] == summary.maxValue && maxIndex < summary.maxIndex)) {
+            summary.maxValue = maxLanes[k];
+            summary.maxIndex = maxIndex;
+        }
+        if (minLanes[k] < summary.minValue || (minLanes[k] == summary.minValue && minIndex < summary.minIndex)) {
+            summary.minValue = minLanes[k];
+            summary.minIndex = minIndex;
+        }
+    }
+}
+
+// One pass: each lane keeps its running sum, max and min and the index
+// where its max and min first appeared (strict compares keep the earliest)
+__attribute__((target("avx2")))
+void avx2SummarizeWindow(const int* data, size_t n, ScanSummary& summary) {
+    __m256i sumLow = _mm256_setzero_si256(), sumHigh = _mm256_setzero_si256();
+    __m256i best = _mm256_set1_epi32(numeric_limits<int>::min()), worst = _mm256_set1_epi32(numeric_limits<int>::max());
+    __m256i bestIndex = _mm256_setzero_si256(), worstIndex = _mm256_setzero_si256();
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), step = _mm256_set1_epi32(8);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        sumLow = _mm256_add_epi64(sumLow, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sumHigh = _mm256_add_epi64(sumHigh, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        __m256i above = _mm256_cmpgt_epi32(v, best), below = _mm256_cmpgt_epi32(worst, v);
+        best = _mm256_max_epi32(best, v);
+        worst = _mm256_min_epi32(worst, v);
+        bestIndex = _mm256_blendv_epi8(bestIndex, index, above);
+        worstIndex = _mm256_blendv_epi8(worstIndex, index, below);
+        index = _mm256_add_epi32(index, step);
+    }
+
+    alignas(32) long long sums[4];
+    alignas(32) int maxLanes[8], maxIndexLanes[8], minLanes[8], minIndexLanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_add_epi64(sumLow, sumHigh));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(maxIndexLanes), bestIndex);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(minLanes), worst);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(minIndexLanes), worstIndex);
+    reduceLanes(maxLanes, maxIndexLanes, minLanes, minIndexLanes, 8, summary);
+    summary.total = sums[0] + sums[1] + sums[2] + sums[3];
+    scalarSummarizeFrom(data, i, n, summary);
+}
+
+void avx2Summarize(const int* data, size_t n, ScanSummary& summary) {
+    summarizeInWindows(avx2SummarizeWindow, data, n, summary);
+}
+
+__attribute__((target("avx2")))
+void avx2CountGreater(const int* data, size_t n, const int* thresholds, size_t numThresholds, size_t* counts) {
+    for (size_t k = 0; k < numThresholds; k++) counts[k] = 0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        // Process one flush window, testing every threshold against each loaded vector
+        size_t windowEnd = min(n - (n - i) % 8, i + 8 * kCounterFlushVectors);
+        for (size_t k0 = 0; k0 < numThresholds; k0 += 8) {
+            size_t batch = min<size_t>(8, numThresholds - k0);
+            __m256i limit[8], acc[8];
+            for (size_t k = 0; k < batch; k++) {
+                limit[k] = _mm256_set1_epi32(thresholds[k0 + k]);
+                acc[k] = _mm256_setzero_si256();
+            }
+            for (size_t j = i; j < windowEnd; j += 8) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j));
+                for (size_t k = 0; k < batch; k++) {
+                    acc[k] = _mm256_sub_epi32(acc[k], _mm256_cmpgt_epi32(v, limit[k]));  // cmpgt yields -1 per hit
+                }
+            }
+            for (size_t k = 0; k < batch; k++) {
+                alignas(32) int lanes[8];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[k]);
+                for (int lane : lanes) counts[k0 + k] += static_cast<unsigned>(lane);
+            }
+        }
+        i = windowEnd;
+    }
+    for (size_t k = 0; k < numThresholds; k++) {
+        for (size_t j = i; j < n; j++) counts[k] += data[j] > thresholds[k];
+    }
+}
+
+// GCC 12 flags the intrinsics' own _mm512_undefined_epi32() placeholders
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+__attribute__((target("avx512f")))
+void avx512SummarizeWindow(const int* data, size_t n, ScanSummary& summary) {
+    __m512i sumLow = _mm512_setzero_si512(), sumHigh = _mm512_setzero_si512();
+    __m512i best = _mm512_set1_epi32(numeric_limits<int>::min()), worst = _mm512_set1_epi32(numeric_limits<int>::max());
+    __m512i bestIndex = _mm512_setzero_si512(), worstIndex = _mm512_setzero_si512();
+    __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i step = _mm512_set1_epi32(16);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(data + i);
+        sumLow = _mm512_add_epi64(sumLow, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        sumHigh = _mm512_add_epi64(sumHigh, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+        __mmask16 above = _mm512_cmpgt_epi32_mask(v, best), below = _mm512_cmpgt_epi32_mask(worst, v);
+        best = _mm512_max_epi32(best, v);
+        worst = _mm512_min_epi32(worst, v);
+        bestIndex = _mm512_mask_mov_epi32(bestIndex, above, index);
+        worstIndex = _mm512_mask_mov_epi32(worstIndex, below, index);
+        index = _mm512_add_epi32(index, step);
+    }
+
+    alignas(64) long long sums[8];
+    alignas(64) int maxLanes[16], maxIndexLanes[16], minLanes[16], minIndexLanes[16];
+    _mm512_store_si512(sums, _mm512_add_epi64(sumLow, sumHigh));
+    _mm512_store_si512(maxLanes, best);
+    _mm512_store_si512(maxIndexLanes, bestIndex);
+    _mm512_store_si512(minLanes, worst);
+    _mm512_store_si512(minIndexLanes, worstIndex);
+    reduceLanes(maxLanes, maxIndexLanes, minLanes, minIndexLanes, 16, summary);
+    summary.total = sums[0] + sums[1] + sums[2] + sums[3] + sums[4] + sums[5] + sums[6] + sums[7];
+    scalarSummarizeFrom(data, i, n, summary);
+}
+
+void avx512Summarize(const int* data, size_t n, ScanSummary& summary) {
+    summarizeInWindows(avx512SummarizeWindow, data, n, summary);
+}
+
+__attribute__((target("avx512f")))
+void avx512CountGreater(const int* data, size_t n, const int* thresholds, size_t numThresholds, size_t* counts) {
+    size_t vectorEnd = n - n % 16;
+    for (size_t k0 = 0; k0 < numThresholds; k0 += 8) {
+        size_t batch = min<size_t>(8, numThresholds - k0);
+        __m512i limit[8];
+        size_t acc[8] = {};
+        for (size_t k = 0; k < batch; k++) limit[k] = _mm512_set1_epi32(thresholds[k0 + k]);
+        for (size_t i = 0; i < vectorEnd; i += 16) {
+            __m512i v = _mm512_loadu_si512(data + i);
+            for (size_t k = 0; k < batch; k++) {
+                acc[k] += __builtin_popcount(_mm512_cmpgt_epi32_mask(v, limit[k]));
+            }
+        }
+        for (size_t k = 0; k < batch; k++) {
+            for (size_t i = vectorEnd; i < n; i++) acc[k] += data[i] > thresholds[k0 + k];
+            counts[k0 + k] = acc[k];
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+const ScanKernels avx2Kernels = {
+    "avx2", avx2Summarize, avx2CountGreater
+};
+
+const ScanKernels avx512Kernels = {
+    "avx512", avx512Summarize, avx512CountGreater
+};
+#endif
+
+// Every kernel set this CPU supports, narrowest first (decided once per process)
+const vector<const ScanKernels*>& supportedScanKernels() {
+    static const vector<const ScanKernels*> supported = [] {
+        vector<const ScanKernels*> kernels = {&scalarKernels};
+#ifdef TRAFFIC_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) kernels.push_back(&avx2Kernels);
+        if (__builtin_cpu_supports("avx512f")) kernels.push_back(&avx512Kernels);
+#endif
+        return kernels;
+    }();
+    return supported;
+}
+
+// The widest kernel set this CPU supports
+const ScanKernels& scanKernels() {
+    return *supportedScanKernels().back();
+}
+
+// Result of one full scan over all segments
+struct TrafficSummary {
+    long long totalVehicles;
+    SegmentHandle busiestSegment;   // kInvalidSegment when there is no data
+    int maxVehicles;
+    SegmentHandle quietestSegment;
+    int minVehicles;
+};
+
 class TrafficMonitor {
 private:
-    vector<string> segmentIDs;      // Dynamic array (vector) for road segment IDs
-    vector<int> vehicleCounts;      // Dynamic array (vector) for vehicle counts
+    SegmentIDInterner segmentIDs;   // Road segment IDs interned to dense handles
+    vector<int> vehicleCounts;      // Dynamic array (vector) of vehicle counts indexed by handle
+    const ScanKernels* kernels;     // Scan kernels used by the summary and count queries
 
 public:
+    explicit TrafficMonitor(const ScanKernels& scan = scanKernels()) : kernels(&scan) {}
+
+    // Resolve an external segment ID to its handle (kInvalidSegment if unknown)
+    SegmentHandle findSegment(const string& segmentID) const {
+        return segmentIDs.find(segmentID);
+    }
+
     // Update traffic data for a specific road segment
     void updateTrafficData(const string& segmentID, int vehicleCount) {
         if (vehicleCount < 0) {
@@ -17,60 +314,301 @@ public:
             return;
         }
 
-        // Find the segment ID in the array
-        auto it = find(segmentIDs.begin(), segmentIDs.end(), segmentID);
-        if (it != segmentIDs.end()) {
-            // If segment exists, update the vehicle count
-            int index = distance(segmentIDs.begin(), it);
-            vehicleCounts[index] = vehicleCount;
-            cout << "Traffic data for segment " << segmentID << " updated to " << vehicleCount << " vehicles.\n";
-        } else {
-            // If segment does not exist, add it to the arrays
-            segmentIDs.push_back(segmentID);
-            vehicleCounts.push_back(vehicleCount);
+        bool added;
+        SegmentHandle handle = segmentIDs.intern(segmentID, &added);
+        if (handle >= vehicleCounts.size()) {
+            vehicleCounts.resize(handle + 1, 0);
+        }
+        vehicleCounts[handle] = vehicleCount;
+        if (added) {
             cout << "Traffic data for segment " << segmentID << " added with " << vehicleCount << " vehicles.\n";
+        } else {
+            cout << "Traffic data for segment " << segmentID << " updated to " << vehicleCount << " vehicles.\n";
         }
     }
 
+    // Update traffic data for an already-resolved segment handle
+    void updateTrafficData(SegmentHandle handle, int vehicleCount) {
+        if (!segmentIDs.isLive(handle) || vehicleCount < 0) return;
+        vehicleCounts[handle] = vehicleCount;
+    }
+
     // Retrieve the vehicle count for a specific road segment
     int getTrafficData(const string& segmentID) const {
-        // Find the segment ID in the array
-        auto it = find(segmentIDs.begin(), segmentIDs.end(), segmentID);
-        if (it != segmentIDs.end()) {
-            // If segment found, return the vehicle count
-            int index = distance(segmentIDs.begin(), it);
-            return vehicleCounts[index];
-        } else {
+        SegmentHandle handle = segmentIDs.find(segmentID);
+        if (handle == kInvalidSegment) {
             // If segment does not exist, return -1
             cout << "No data found for segment ID: " << segmentID << endl;
             return -1;
         }
+        return vehicleCounts[handle];
+    }
+
+    // Retrieve the vehicle count for a segment handle (-1 if not live)
+    int getTrafficData(SegmentHandle handle) const {
+        return segmentIDs.isLive(handle) ? vehicleCounts[handle] : -1;
+    }
+
+    // Total, busiest and quietest segment in one fused scan
+    TrafficSummary summarizeTraffic() const {
+        size_t n = vehicleCounts.size();
+        TrafficSummary summary = {0, kInvalidSegment, 0, kInvalidSegment, 0};
+        if (n == 0) return summary;
+
+        ScanSummary scan;
+        kernels->summarize(vehicleCounts.data(), n, scan);
+        summary.totalVehicles = scan.total;
+        summary.busiestSegment = static_cast<SegmentHandle>(scan.maxIndex);
+        summary.maxVehicles = scan.maxValue;
+        summary.quietestSegment = static_cast<SegmentHandle>(scan.minIndex);
+        summary.minVehicles = scan.minValue;
+        return summary;
+    }
+
+    // Number of segments carrying more than threshold vehicles
+    size_t countSegmentsAbove(int threshold) const {
+        size_t count = 0;
+        kernels->countGreater(vehicleCounts.data(), vehicleCounts.size(), &threshold, 1, &count);
+        return count;
+    }
+
+    // Histogram of segments per load band. bandLimits must be ascending; band k
+    // holds counts in (bandLimits[k-1], bandLimits[k]], and the last band holds
+    // everything above bandLimits.back().
+    vector<size_t> loadBandHistogram(const vector<int>& bandLimits) const {
+        vector<size_t> above(bandLimits.size());
+        kernels->countGreater(vehicleCounts.data(), vehicleCounts.size(),
+                              bandLimits.data(), bandLimits.size(), above.data());
+
+        vector<size_t> histogram(bandLimits.size() + 1);
+        size_t previous = vehicleCounts.size();
+        for (size_t k = 0; k < above.size(); k++) {
+            histogram[k] = previous - above[k];
+            previous = above[k];
+        }
+        histogram.back() = previous;
+        return histogram;
+    }
+
+    const string& segmentName(SegmentHandle handle) const {
+        return segmentIDs.name(handle);
     }
 
     // Display all traffic data (for debugging or analysis purposes)
     void displayTrafficData() const {
-        if (segmentIDs.empty()) {
+        if (segmentIDs.size() == 0) {
             cout << "No traffic data available.\n";
             return;
         }
 
         cout << "Traffic Data for each Road Segment:" << endl;
-        for (size_t i = 0; i < segmentIDs.size(); i++) {
-            cout << "Segment ID " << segmentIDs[i] << ": " << vehicleCounts[i] << " vehicles" << endl;
+        for (SegmentHandle handle = 0; handle < segmentIDs.handleLimit(); handle++) {
+            if (!segmentIDs.isLive(handle)) continue;
+            cout << "Segment ID " << segmentIDs.name(handle) << ": " << vehicleCounts[handle] << " vehicles" << endl;
+        }
+    }
+};
+
+// Upper limits of the light / moderate / heavy load bands; anything above is congested
+const vector<int> kLoadBandLimits = {20, 50, 100};
+const char* const kLoadBandNames[] = {"Light (0-20)", "Moderate (21-50)", "Heavy (51-100)", "Congested (101+)"};
+
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its arguments. --generate writes a random trace; --replay runs
+// it through a naive reference (scalar loops, no kernels) and through
+// TrafficMonitor once per scan kernel set this CPU supports (scalar, avx2,
+// avx512), times each and reports the first answer that differs.
+//
+//   U segment count        add or update a segment
+//   G segment              vehicle count (-> -1 if unknown)
+//   S                      summary (-> total busiest max quietest min)
+//   C threshold            segments above threshold
+//   H limit ...            load band histogram for ascending limits
+
+// Reference for TrafficMonitor: segments in insertion order (the handle
+// order), every query a plain loop
+class ReferenceTraffic {
+private:
+    unordered_map<string, size_t> index;
+    vector<string> names;
+    vector<int> counts;
+
+public:
+    void updateTrafficData(const string& segmentID, int vehicleCount) {
+        if (vehicleCount < 0) return;
+        auto result = index.emplace(segmentID, names.size());
+        if (result.second) {
+            names.push_back(segmentID);
+            counts.push_back(0);
+        }
+        counts[result.first->second] = vehicleCount;
+    }
+
+    int getTrafficData(const string& segmentID) const {
+        auto it = index.find(segmentID);
+        return it == index.end() ? -1 : counts[it->second];
+    }
+
+    string summary() const {
+        if (counts.empty()) return "none";
+        size_t busiest = 0, quietest = 0;
+        long long total = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            total += counts[i];
+            if (counts[i] > counts[busiest]) busiest = i;
+            if (counts[i] < counts[quietest]) quietest = i;
+        }
+        return to_string(total) + " " + names[busiest] + " " + to_string(counts[busiest]) + " " + names[quietest] +
+               " " + to_string(counts[quietest]);
+    }
+
+    size_t countSegmentsAbove(int threshold) const {
+        return count_if(counts.begin(), counts.end(), [threshold](int count) { return count > threshold; });
+    }
+
+    vector<size_t> loadBandHistogram(const vector<int>& bandLimits) const {
+        vector<size_t> histogram(bandLimits.size() + 1);
+        for (int count : counts) {
+            histogram[lower_bound(bandLimits.begin(), bandLimits.end(), count) - bandLimits.begin()]++;
         }
+        return histogram;
     }
 };
 
+string summaryAnswer(const TrafficMonitor& monitor) {
+    TrafficSummary summary = monitor.summarizeTraffic();
+    if (summary.busiestSegment == kInvalidSegment) return "none";
+    return to_string(summary.totalVehicles) + " " + monitor.segmentName(summary.busiestSegment) + " " +
+           to_string(summary.maxVehicles) + " " + monitor.segmentName(summary.quietestSegment) + " " +
+           to_string(summary.minVehicles);
+}
+
+string summaryAnswer(const ReferenceTraffic& reference) { return reference.summary(); }
+
+// Answer one trace op on a TrafficMonitor or the reference
+template <typename Monitor>
+string applyToMonitor(Monitor& monitor, const TraceOp& op) {
+    switch (op.op) {
+        case 'U':
+            monitor.updateTrafficData(op.args.at(0), stoi(op.args.at(1)));
+            return "";
+        case 'G':
+            return to_string(monitor.getTrafficData(op.args.at(0)));
+        case 'S':
+            return summaryAnswer(monitor);
+        case 'C':
+            return to_string(monitor.countSegmentsAbove(stoi(op.args.at(0))));
+        case 'H': {
+            vector<int> limits;
+            for (const string& arg : op.args) limits.push_back(stoi(arg));
+            if (!is_sorted(limits.begin(), limits.end())) throw invalid_argument("band limits must ascend");
+            vector<string> bands;
+            for (size_t band : monitor.loadBandHistogram(limits)) bands.push_back(to_string(band));
+            return joinAnswer(bands);
+        }
+        default:
+            return "";
+    }
+}
+
+// Write a random trace over the given number of segment IDs. Counts are
+// mostly within the load bands, with occasional negative (rejected) and
+// very large ones; segments are added as they are first updated.
+bool generateTrafficTrace(const string& path, long long operations, int segments, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    auto segment = [&]() { return "S" + to_string(1 + rng() % segments); };
+    auto count = [&]() -> long long {
+        unsigned kind = rng() % 100;
+        return kind < 95 ? rng() % 150 : kind < 97 ? -(long long)(rng() % 10) - 1 : rng() % 2000000000;
+    };
+
+    out << "# array.cpp TrafficMonitor trace, seed " << seed << "\n";
+    for (long long i = 0; i < operations; i++) {
+        unsigned kind = rng() % 20;
+        if (kind < 12) {
+            out << "U " << segment() << " " << count() << "\n";
+        } else if (kind < 15) {
+            out << "G " << segment() << "\n";
+        } else if (kind < 17) {
+            out << "S\n";
+        } else if (kind < 19) {
+            out << "C " << (int)(rng() % 200) - 10 << "\n";
+        } else {
+            vector<int> limits(1 + rng() % 8);
+            for (int& limit : limits) limit = (int)(rng() % 200) - 10;
+            sort(limits.begin(), limits.end());
+            out << "H";
+            for (int limit : limits) out << " " << limit;
+            out << "\n";
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and TrafficMonitor per kernel set; returns the exit code
+int replayTrafficTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    try {
+        vector<string> expected, answers;
+        ReferenceTraffic reference;
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return applyToMonitor(reference, op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        for (const ScanKernels* kernels : supportedScanKernels()) {
+            TrafficMonitor monitor(*kernels);
+            {
+                QuietOutput quiet;   // TrafficMonitor reports every update on cout
+                seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToMonitor(monitor, op); });
+            }
+            string name = string("TrafficMonitor (") + kernels->name + ")";
+            matched = reportRun(name, trace, seconds, answers, &expected) && matched;
+        }
+        return matched ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
 void displayMenu() {
     cout << "\nMenu:\n";
     cout << "1. Update traffic data\n";
     cout << "2. Retrieve traffic data\n";
     cout << "3. Display all traffic data\n";
-    cout << "4. Exit\n";
+    cout << "4. Display traffic summary\n";
+    cout << "5. Count segments above a threshold\n";
+    cout << "6. Display load band histogram\n";
+    cout << "7. Exit\n";
     cout << "Enter your choice: ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> <segments> [seed]
+    //   --replay <trace>
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        int segments = atoi(argv[4]);
+        if (segments < 1) {
+            cerr << "Segment count must be positive.\n";
+            return 1;
+        }
+        if (!generateTrafficTrace(argv[2], atoll(argv[3]), segments, argc >= 6 ? (unsigned)atoi(argv[5]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayTrafficTrace(argv[2]);
+    }
+
     TrafficMonitor monitor;
     string segmentID;
     int vehicleCount;
@@ -102,14 +640,46 @@ int main() {
             monitor.displayTrafficData();
             break;
 
-        case 4:
+        case 4: {
+            TrafficSummary summary = monitor.summarizeTraffic();
+            if (summary.busiestSegment == kInvalidSegment) {
+                cout << "No traffic data available.\n";
+                break;
+            }
+            cout << "Total vehicles: " << summary.totalVehicles << endl;
+            cout << "Busiest segment: " << monitor.segmentName(summary.busiestSegment)
+                 << " (" << summary.maxVehicles << " vehicles)" << endl;
+            cout << "Quietest segment: " << monitor.segmentName(summary.quietestSegment)
+                 << " (" << summary.minVehicles << " vehicles)" << endl;
+            break;
+        }
+
+        case 5: {
+            int threshold;
+            cout << "Enter vehicle count threshold: ";
+            cin >> threshold;
+            cout << "Segments with more than " << threshold << " vehicles: "
+                 << monitor.countSegmentsAbove(threshold) << endl;
+            break;
+        }
+
+        case 6: {
+            vector<size_t> histogram = monitor.loadBandHistogram(kLoadBandLimits);
+            cout << "Segments per load band:" << endl;
+            for (size_t k = 0; k < histogram.size(); k++) {
+                cout << kLoadBandNames[k] << ": " << histogram[k] << endl;
+            }
+            break;
+        }
+
+        case 7:
             cout << "Exiting...\n";
             break;
 
         default:
-            cout << "Invalid choice. Please enter a number between 1 and 4.\n";
+            cout << "Invalid choice. Please enter a number between 1 and 7.\n";
         }
-    } while (choice != 4);
+    } while (choice != 7);
 
     return 0;
 }
@@ -1,10 +1,60 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "slot_state_log.h"
+#include "trace_harness.h"
+
 using namespace std;
 
 class EVChargingArray {
 private:
     vector<bool> stationStatus; // Array to track station status: true = Free, false = Occupied
+    SlotStateLog* journal = nullptr; // Durable log of status changes, once attached
+    uint64_t loggedSeq = 0; // Journal sequence of the last change
+    uint64_t acknowledgedSeq = 0; // Last change waitDurable has reported on
+    static constexpr size_t kCheckpointInterval = 10000;
+
+    // Queue a change that has already been applied on the journal; see
+    // waitDurable. Record: 'O' (occupied) or 'F' (free) and a 32-bit station ID.
+    void logChange(char op, int stationID) {
+        if (!journal) return;
+        string record(1, op);
+        record.append(reinterpret_cast<const char*>(&stationID), sizeof(stationID));
+        loggedSeq = journal->append(record);
+        if (journal->recordsSinceCheckpoint() >= kCheckpointInterval) journal->checkpoint(snapshot());
+    }
+
+    // Re-apply a journaled change during recovery
+    void replayChange(const string& record) {
+        if (record.size() != 1 + sizeof(int)) return;
+        int stationID;
+        memcpy(&stationID, record.data() + 1, sizeof(stationID));
+        if (stationID >= 0 && stationID < (int)stationStatus.size()) stationStatus[stationID] = record[0] == 'F';
+    }
+
+    // One byte per station: 1 = Free, 0 = Occupied
+    string snapshot() const {
+        string bytes(stationStatus.size(), 0);
+        for (size_t i = 0; i < stationStatus.size(); ++i) bytes[i] = stationStatus[i] ? 1 : 0;
+        return bytes;
+    }
+
+    // A snapshot also carries the station count, which wins over the configured one
+    void restore(const string& bytes) {
+        stationStatus.assign(bytes.size(), true);
+        for (size_t i = 0; i < bytes.size(); ++i) stationStatus[i] = bytes[i] != 0;
+    }
 
 public:
     // Constructor to initialize stations
@@ -18,6 +68,7 @@ public:
         if (isValidStation(stationID)) {
             if (stationStatus[stationID]) {
                 stationStatus[stationID] = false;
+                logChange('O', stationID);
                 cout << "Station " << stationID << " is now Occupied.\n";
             } else {
                 cout << "Station " << stationID << " is already Occupied.\n";
@@ -30,6 +81,7 @@ public:
         if (isValidStation(stationID)) {
             if (!stationStatus[stationID]) {
                 stationStatus[stationID] = true;
+                logChange('F', stationID);
                 cout << "Station " << stationID << " is now Free.\n";
             } else {
                 cout << "Station " << stationID << " is already Free.\n";
@@ -37,6 +89,34 @@ public:
         }
     }
 
+    // Recover station status from the journal at basePath, then log every
+    // later change to it. Returns false if the journal cannot be opened.
+    bool attachJournal(SlotStateLog& log, const string& basePath) {
+        bool opened = log.open(basePath,
+                               [this](const string& bytes) { restore(bytes); },
+                               [this](const string& record) { replayChange(record); });
+        if (!opened) return false;
+        journal = &log;
+        // Start from a snapshot so a restart with a different count replays consistently
+        if (log.recordsSinceCheckpoint() == 0) log.checkpoint(snapshot());
+        return true;
+    }
+
+    // Block until every journaled change so far is on disk. This is the
+    // acknowledgement point for the changes since the last call, which are
+    // only queued when made so a batch shares one flush. Returns false if
+    // any of them could not be saved (they stay applied in memory).
+    bool waitDurable() {
+        if (!journal || acknowledgedSeq == loggedSeq) return true;
+        acknowledgedSeq = loggedSeq;
+        return journal->waitDurable(loggedSeq);
+    }
+
+    int stationCount() const { return (int)stationStatus.size(); }
+
+    // Status of a valid station ID, without console output
+    bool isFree(int stationID) const { return stationStatus[stationID]; }
+
     // Display all station statuses
     void displayStations() {
         cout << "\nCharging Station Status:\n";
@@ -56,15 +136,324 @@ private:
     }
 };
 
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its arguments. --generate writes a random trace; --replay runs
+// it through a naive reference and through EVChargingArray, with and without
+// a journal, then reopens the journal and checks the recovered stations.
+// --crash-replay runs the trace in a child process that journals every
+// change, SIGKILLs it at a random point and checks that reopening the
+// journal recovers a state the trace passed through no earlier than the
+// last change the child had acknowledged.
+//
+//   N n                    number of stations, all Free (first line)
+//   O id / F id            occupy / free a station (invalid IDs are ignored)
+//   S id                   status (-> free, occupied or invalid)
+//   C                      number of free stations
+//   W                      wait until every change so far is durable (-> 1/0)
+
+// Reference for EVChargingArray: plain flags, no journal
+class ReferenceStations {
+private:
+    vector<bool> free;
+
+public:
+    explicit ReferenceStations(int numStations) : free(numStations, true) {}
+
+    void occupyStation(int stationID) {
+        if (stationID >= 0 && stationID < stationCount()) free[stationID] = false;
+    }
+
+    void freeStation(int stationID) {
+        if (stationID >= 0 && stationID < stationCount()) free[stationID] = true;
+    }
+
+    bool waitDurable() { return true; }
+    int stationCount() const { return (int)free.size(); }
+    bool isFree(int stationID) const { return free[stationID]; }
+};
+
+// Answer one trace op on EVChargingArray or the reference
+template <typename Stations>
+string applyToStations(Stations& stations, const TraceOp& op) {
+    switch (op.op) {
+        case 'O':
+            stations.occupyStation(stoi(op.args.at(0)));
+            return "";
+        case 'F':
+            stations.freeStation(stoi(op.args.at(0)));
+            return "";
+        case 'S': {
+            int stationID = stoi(op.args.at(0));
+            if (stationID < 0 || stationID >= stations.stationCount()) return "invalid";
+            return stations.isFree(stationID) ? "free" : "occupied";
+        }
+        case 'C': {
+            int count = 0;
+            for (int i = 0; i < stations.stationCount(); i++) count += stations.isFree(i);
+            return to_string(count);
+        }
+        case 'W':
+            return stations.waitDurable() ? "1" : "0";
+        default:
+            return "";
+    }
+}
+
+template <typename Stations>
+bool sameStations(const EVChargingArray& stations, const Stations& expected) {
+    if (stations.stationCount() != expected.stationCount()) return false;
+    for (int i = 0; i < stations.stationCount(); i++) {
+        if (stations.isFree(i) != expected.isFree(i)) return false;
+    }
+    return true;
+}
+
+// Remove a journal's files so a run starts from an empty one
+void removeJournal(const string& basePath) {
+    for (const char* suffix : {".log", ".ckpt", ".ckpt.tmp"}) unlink((basePath + suffix).c_str());
+}
+
+// Write a random trace over the given number of stations. Changes come in
+// batches ending with a W, as the menu waits after every command; IDs are
+// occasionally out of range.
+bool generateStationTrace(const string& path, long long operations, int stations, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    auto station = [&]() { return rng() % 50 ? (int)(rng() % stations) : (int)(rng() % 3) - 1 + (rng() % 2 ? stations : 0); };
+
+    out << "# EVChargingArray trace, seed " << seed << "\n";
+    out << "N " << stations << "\n";
+    long long untilWait = 1 + rng() % 64;
+    for (long long i = 0; i < operations; i++) {
+        if (--untilWait == 0) {
+            out << "W\n";
+            untilWait = 1 + rng() % 64;
+            continue;
+        }
+        unsigned kind = rng() % 20;
+        if (kind < 9) {
+            out << "O " << station() << "\n";
+        } else if (kind < 18) {
+            out << "F " << station() << "\n";
+        } else if (kind < 19) {
+            out << "S " << station() << "\n";
+        } else {
+            out << "C\n";
+        }
+    }
+    out << "W\n";
+    return (bool)out;
+}
+
+// Read a trace that must start with N <stations>; returns the station count, or 0
+int readStationTrace(const string& path, vector<TraceOp>& trace) {
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 0;
+    }
+    if (trace.empty() || trace[0].op != 'N' || trace[0].args.empty() || atoi(trace[0].args[0].c_str()) < 1) {
+        cerr << "Trace must start with N <stations>.\n";
+        return 0;
+    }
+    return atoi(trace[0].args[0].c_str());
+}
+
+// Replay a trace against the reference and EVChargingArray, then again with
+// a journal at journalPath that is reopened afterwards; returns the exit code
+int replayStationTrace(const string& path, const string& journalPath) {
+    vector<TraceOp> trace;
+    int n = readStationTrace(path, trace);
+    if (n == 0) return 1;
+    try {
+        vector<string> expected, answers;
+        ReferenceStations reference(n);
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return applyToStations(reference, op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        {
+            QuietOutput quiet;   // EVChargingArray reports every change on cout
+            EVChargingArray stations(n);
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToStations(stations, op); });
+        }
+        matched = reportRun("EVChargingArray", trace, seconds, answers, &expected) && matched;
+
+        removeJournal(journalPath);
+        {
+            SlotStateLog journal;
+            QuietOutput quiet;
+            EVChargingArray stations(n);
+            if (!stations.attachJournal(journal, journalPath)) {
+                cerr << "Cannot open journal " << journalPath << ".\n";
+                return 1;
+            }
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToStations(stations, op); });
+        }
+        matched = reportRun("EVChargingArray + journal", trace, seconds, answers, &expected) && matched;
+
+        bool recovered;
+        {
+            SlotStateLog journal;
+            QuietOutput quiet;
+            EVChargingArray stations(n);
+            recovered = stations.attachJournal(journal, journalPath) && sameStations(stations, reference);
+        }
+        removeJournal(journalPath);
+        cout << "Reopened journal: " << (recovered ? "matches reference" : "MISMATCH with the reference's final state") << "\n";
+        return matched && recovered ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
+// Run the trace in a child that journals to journalPath and reports the
+// number of ops covered by each successful W on a pipe; SIGKILL it after a
+// random number of acknowledgements and a random delay, reopen the journal
+// and require the recovered stations to equal the reference after some op
+// at or past the last acknowledged one. Repeats for the given number of
+// rounds; returns the exit code.
+int crashReplayStationTrace(const string& path, const string& journalPath, int rounds, unsigned seed) {
+    vector<TraceOp> trace;
+    int n = readStationTrace(path, trace);
+    if (n == 0) return 1;
+    size_t acknowledgements = count_if(trace.begin(), trace.end(), [](const TraceOp& op) { return op.op == 'W'; });
+    mt19937 rng(seed);
+    int failures = 0;
+
+    for (int round = 1; round <= rounds; round++) {
+        removeJournal(journalPath);
+        int channel[2];
+        if (pipe(channel) != 0) {
+            cerr << "Cannot create a pipe.\n";
+            return 1;
+        }
+        cout.flush();
+        pid_t child = fork();
+        if (child == 0) {
+            close(channel[0]);
+            QuietOutput quiet;
+            SlotStateLog journal;
+            EVChargingArray stations(n);
+            if (!stations.attachJournal(journal, journalPath)) _exit(2);
+            for (size_t i = 0; i < trace.size(); i++) {
+                if (applyToStations(stations, trace[i]) == "0") _exit(3);
+                uint64_t done = i + 1;
+                if (trace[i].op == 'W' && write(channel[1], &done, sizeof(done)) != sizeof(done)) _exit(4);
+            }
+            _exit(0);
+        }
+        close(channel[1]);
+        if (child < 0) {
+            close(channel[0]);
+            cerr << "Cannot fork.\n";
+            return 1;
+        }
+
+        // Kill after a random number of acknowledgements, then collect any
+        // the child managed to send before it died
+        size_t killAfter = rng() % (acknowledgements + 1), seen = 0;
+        uint64_t acknowledged = 0, done;
+        while (seen < killAfter && read(channel[0], &done, sizeof(done)) == sizeof(done)) {
+            acknowledged = done;
+            seen++;
+        }
+        usleep(rng() % 2000);
+        kill(child, SIGKILL);
+        while (read(channel[0], &done, sizeof(done)) == sizeof(done)) acknowledged = done;
+        close(channel[0]);
+        int status;
+        waitpid(child, &status, 0);
+        if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+            cout << "Round " << round << ": the child could not journal (exit " << WEXITSTATUS(status) << ")\n";
+            failures++;
+            continue;
+        }
+
+        SlotStateLog journal;
+        unique_ptr<EVChargingArray> recovered;
+        bool opened;
+        {
+            QuietOutput quiet;
+            recovered.reset(new EVChargingArray(n));
+            opened = recovered->attachJournal(journal, journalPath);
+        }
+        if (!opened || recovered->stationCount() != n) {
+            cout << "Round " << round << ": cannot reopen the journal\n";
+            failures++;
+            continue;
+        }
+
+        // Walk the reference from the acknowledged op onwards, tracking how
+        // many stations differ from the recovered ones
+        ReferenceStations reference(n);
+        for (size_t i = 0; i < acknowledged; i++) applyToStations(reference, trace[i]);
+        int differing = 0;
+        for (int i = 0; i < n; i++) differing += recovered->isFree(i) != reference.isFree(i);
+        size_t matchedAt = acknowledged;
+        while (differing != 0 && matchedAt < trace.size()) {
+            const TraceOp& op = trace[matchedAt++];
+            if (op.op != 'O' && op.op != 'F') continue;
+            int stationID = stoi(op.args.at(0));
+            if (stationID < 0 || stationID >= n) continue;
+            differing -= recovered->isFree(stationID) != reference.isFree(stationID);
+            applyToStations(reference, op);
+            differing += recovered->isFree(stationID) != reference.isFree(stationID);
+        }
+        cout << "Round " << round << ": killed with " << acknowledged << " of " << trace.size() << " ops acknowledged; ";
+        if (differing == 0) {
+            cout << "recovered the state after op " << matchedAt << "\n";
+        } else {
+            cout << "recovered stations match no state at or after op " << acknowledged << "\n";
+            failures++;
+        }
+    }
+    removeJournal(journalPath);
+    cout << rounds - failures << " of " << rounds << " crash rounds recovered an acknowledged state\n";
+    return failures == 0 ? 0 : 1;
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> <stations> [seed]
+    //   --replay <trace> [journal base path]
+    //   --crash-replay <trace> <journal base path> [rounds] [seed]
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        int stations = atoi(argv[4]);
+        if (stations < 1) {
+            cerr << "Station count must be positive.\n";
+            return 1;
+        }
+        if (!generateStationTrace(argv[2], atoll(argv[3]), stations, argc >= 6 ? (unsigned)atoi(argv[5]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayStationTrace(argv[2], argc >= 4 ? argv[3] : "ev_stations_replay");
+    }
+    if (argc >= 4 && string(argv[1]) == "--crash-replay") {
+        return crashReplayStationTrace(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 20,
+                                       argc >= 6 ? (unsigned)atoi(argv[5]) : 1);
+    }
+
     int numStations;
     cout << "Enter the number of charging stations: ";
     cin >> numStations;
 
     EVChargingArray chargingStations(numStations);
+    SlotStateLog journal;
     int choice, stationID;
 
+    if (chargingStations.attachJournal(journal, "ev_stations")) {
+        cout << "Journal recovered " << chargingStations.stationCount() << " stations.\n";
+    } else {
+        cout << "Warning: station journal unavailable; changes will not survive a restart.\n";
+    }
+
     while (true) {
         cout << "\nMenu:\n";
         cout << "1. Occupy a Station\n";
@@ -94,5 +483,6 @@ int main() {
         default:
             cout << "Invalid choice. Please try again.\n";
         }
+        if (!chargingStations.waitDurable()) cout << "Error: station changes could not be saved to the journal.\n";
     }
 }
@@ -1,64 +1,490 @@
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+
+#include "slot_schedule.h"
+#include "slot_state_log.h"
+#include "trace_harness.h"
+
 using namespace std;
 
 // Node structure for BST
 struct BSTNode {
     int slotID;             // Unique ID for the charging slot
     bool isAvailable;       // Availability of the slot
+    int height;             // Height of the subtree rooted here (leaf = 1)
+    int freeCount;          // Number of available slots in this subtree
     BSTNode* left;          // Left child
     BSTNode* right;         // Right child
 
-    BSTNode(int id) : slotID(id), isAvailable(true), left(nullptr), right(nullptr) {}
+    BSTNode(int id) : slotID(id), isAvailable(true), height(1), freeCount(1), left(nullptr), right(nullptr) {}
 };
 
-// Class for managing the BST
+// Class for managing the BST. The tree is kept height-balanced (AVL) and every
+// node knows how many free slots its subtree holds, so searches by ID, rank
+// or free-slot range all run in O(log n).
 class EVSlotBST {
 private:
     BSTNode* root;
+    vector<vector<BSTNode>> nodeBlocks;   // Node storage; a block never grows past its reserved size
 
-    // Helper function to insert a slot into the BST
-    BSTNode* insertSlot(BSTNode* node, int slotID) {
-        if (!node) return new BSTNode(slotID);
+    struct SlotState {
+        int slotID;
+        bool isAvailable;
+    };
 
-        if (slotID < node->slotID) {
-            node->left = insertSlot(node->left, slotID);
-        } else if (slotID > node->slotID) {
-            node->right = insertSlot(node->right, slotID);
-        } else {
-            cout << "Slot with ID " << slotID << " already exists.\n";
+    // Future bookings of every slot in the tree, indexed by free gap. It
+    // tracks the same slot set as the tree, so under scheduleLock checking
+    // that a slot exists and booking it are one step.
+    SlotScheduleIndex schedules;
+    mutable mutex scheduleLock;
+
+    // Take a node from the current block, opening a larger block when it is full
+    BSTNode* allocateNode(int slotID) {
+        if (nodeBlocks.empty() || nodeBlocks.back().size() == nodeBlocks.back().capacity()) {
+            nodeBlocks.emplace_back();
+            nodeBlocks.back().reserve(max<size_t>(64, slotCount()));
+        }
+        nodeBlocks.back().emplace_back(slotID);
+        return &nodeBlocks.back().back();
+    }
+
+    size_t slotCount() const {
+        size_t count = 0;
+        for (const auto& block : nodeBlocks) count += block.size();
+        return count;
+    }
+
+    // Link nodes[lo..hi] (already in ID order) into a perfectly balanced subtree
+    static BSTNode* linkBalanced(vector<BSTNode>& nodes, int lo, int hi) {
+        if (lo > hi) return nullptr;
+        int mid = lo + (hi - lo) / 2;
+        BSTNode* node = &nodes[mid];
+        node->left = linkBalanced(nodes, lo, mid - 1);
+        node->right = linkBalanced(nodes, mid + 1, hi);
+        update(node);
+        return node;
+    }
+
+    // Replace the whole tree with the given slots (sorted by ID, no duplicates),
+    // stored in one contiguous block and linked in O(n)
+    void rebuild(const vector<SlotState>& slots) {
+        vector<BSTNode> nodes;
+        nodes.reserve(slots.size());
+        for (const SlotState& slot : slots) {
+            nodes.emplace_back(slot.slotID);
+            nodes.back().isAvailable = slot.isAvailable;
+        }
+        nodeBlocks.clear();
+        nodeBlocks.push_back(move(nodes));
+        root = linkBalanced(nodeBlocks.back(), 0, static_cast<int>(slots.size()) - 1);
+    }
+
+    // Reset the schedule index to exactly the given slots (sorted by ID), unbooked
+    void resetSchedules(const vector<SlotState>& slots) {
+        lock_guard<mutex> lock(scheduleLock);
+        schedules.clear();
+        for (size_t i = 0; i < slots.size();) {
+            size_t j = i;
+            while (j + 1 < slots.size() && slots[j + 1].slotID == slots[j].slotID + 1) j++;
+            schedules.addSlots(slots[i].slotID, slots[j].slotID);
+            i = j + 1;
+        }
+    }
+
+    // All slots in ID order
+    vector<SlotState> collectSlots() const {
+        vector<SlotState> slots;
+        slots.reserve(slotCount());
+        for (const BSTNode& node : *this) {
+            slots.push_back({node.slotID, node.isAvailable});
+        }
+        return slots;
+    }
+
+    static int height(BSTNode* node) { return node ? node->height : 0; }
+    static int freeCount(BSTNode* node) { return node ? node->freeCount : 0; }
+
+    // Recompute a node's height and free count from its children
+    static void update(BSTNode* node) {
+        node->height = 1 + max(height(node->left), height(node->right));
+        node->freeCount = freeCount(node->left) + freeCount(node->right) + (node->isAvailable ? 1 : 0);
+    }
+
+    static BSTNode* rotateRight(BSTNode* node) {
+        BSTNode* pivot = node->left;
+        node->left = pivot->right;
+        pivot->right = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    static BSTNode* rotateLeft(BSTNode* node) {
+        BSTNode* pivot = node->right;
+        node->right = pivot->left;
+        pivot->left = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    // Restore the AVL height invariant at node after one of its subtrees changed
+    static BSTNode* rebalance(BSTNode* node) {
+        update(node);
+        int balance = height(node->left) - height(node->right);
+        if (balance > 1) {
+            if (height(node->left->left) < height(node->left->right)) node->left = rotateLeft(node->left);
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            if (height(node->right->right) < height(node->right->left)) node->right = rotateRight(node->right);
+            return rotateLeft(node);
         }
         return node;
     }
 
+    // Helper function to insert a slot into the BST. Walks down iteratively,
+    // then relinks and rebalances the recorded path bottom-up.
+    BSTNode* insertSlot(BSTNode* node, int slotID) {
+        vector<BSTNode*> path;
+        BSTNode* current = node;
+        while (current) {
+            if (slotID == current->slotID) {
+                cout << "Slot with ID " << slotID << " already exists.\n";
+                return node;
+            }
+            path.push_back(current);
+            current = slotID < current->slotID ? current->left : current->right;
+        }
+
+        BSTNode* child = allocateNode(slotID);
+        {
+            lock_guard<mutex> lock(scheduleLock);
+            schedules.addSlot(slotID);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            BSTNode* parent = *it;
+            if (slotID < parent->slotID) {
+                parent->left = child;
+            } else {
+                parent->right = child;
+            }
+            child = rebalance(parent);
+        }
+        return child;
+    }
+
+    // Set a slot's availability and fix the free counts on its root path.
+    // Returns false if the slot does not exist.
+    bool setAvailability(int slotID, bool available) {
+        vector<BSTNode*> path;
+        BSTNode* node = root;
+        while (node && node->slotID != slotID) {
+            path.push_back(node);
+            node = slotID < node->slotID ? node->left : node->right;
+        }
+        if (!node) return false;
+
+        node->isAvailable = available;
+        update(node);
+        for (auto it = path.rbegin(); it != path.rend(); ++it) update(*it);
+        return true;
+    }
+
+    // Number of free slots with ID < slotID (or <= slotID when inclusive)
+    int countFreeBelow(int slotID, bool inclusive) const {
+        int count = 0;
+        BSTNode* node = root;
+        while (node) {
+            if (node->slotID < slotID || (inclusive && node->slotID == slotID)) {
+                count += freeCount(node->left) + (node->isAvailable ? 1 : 0);
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return count;
+    }
+
     // Helper function to find a slot in the BST
-    BSTNode* findSlot(BSTNode* node, int slotID) {
-        if (!node || node->slotID == slotID) return node;
+    BSTNode* findSlot(BSTNode* node, int slotID) const {
+        while (node && node->slotID != slotID) {
+            node = slotID < node->slotID ? node->left : node->right;
+        }
+        return node;
+    }
 
-        if (slotID < node->slotID) {
-            return findSlot(node->left, slotID);
-        } else {
-            return findSlot(node->right, slotID);
+    SlotStateLog* journal = nullptr;   // Durable log of slot changes, once attached
+    uint64_t loggedSeq = 0;            // Journal sequence of the last change
+    uint64_t acknowledgedSeq = 0;      // Last change waitDurable has reported on
+    static constexpr size_t kCheckpointInterval = 10000;
+
+    // Queue a change that has already been applied on the journal; see
+    // waitDurable. Every kCheckpointInterval records the log is compacted
+    // into a snapshot. Record: op ('A' add, 'R' add range, 'X' remove range,
+    // 'O' occupy, 'F' free) followed by two 32-bit slot IDs.
+    void logChange(char op, int a, int b = 0) {
+        if (!journal) return;
+        string record(1, op);
+        record.append(reinterpret_cast<const char*>(&a), sizeof(a));
+        record.append(reinterpret_cast<const char*>(&b), sizeof(b));
+        loggedSeq = journal->append(record);
+        if (journal->recordsSinceCheckpoint() >= kCheckpointInterval) journal->checkpoint(snapshot());
+    }
+
+    // Re-apply a journaled change during recovery
+    void replayChange(const string& record) {
+        if (record.size() != 1 + 2 * sizeof(int)) return;
+        int a, b;
+        memcpy(&a, record.data() + 1, sizeof(a));
+        memcpy(&b, record.data() + 1 + sizeof(a), sizeof(b));
+        switch (record[0]) {
+        case 'A': if (!findSlot(root, a)) root = insertSlot(root, a); break;
+        case 'R': addSlotRange(a, b); break;
+        case 'X': removeSlotRange(a, b); break;
+        case 'O': setAvailability(a, false); break;
+        case 'F': setAvailability(a, true); break;
+        }
+    }
+
+    // Every slot and its availability, in ID order
+    string snapshot() const {
+        string bytes;
+        for (const BSTNode& node : *this) {
+            bytes.append(reinterpret_cast<const char*>(&node.slotID), sizeof(node.slotID));
+            bytes.push_back(node.isAvailable ? 1 : 0);
         }
+        return bytes;
     }
 
-    // Helper function to display the BST in-order
-    void displaySlots(BSTNode* node) {
-        if (!node) return;
-        displaySlots(node->left);
-        cout << "Slot ID: " << node->slotID
-             << " | Availability: " << (node->isAvailable ? "Available" : "Occupied") << endl;
-        displaySlots(node->right);
+    void restore(const string& bytes) {
+        const size_t entry = sizeof(int) + 1;
+        vector<SlotState> slots(bytes.size() / entry);
+        for (size_t i = 0; i < slots.size(); i++) {
+            memcpy(&slots[i].slotID, bytes.data() + i * entry, sizeof(int));
+            slots[i].isAvailable = bytes[i * entry + sizeof(int)] != 0;
+        }
+        rebuild(slots);
+        resetSchedules(slots);
     }
 
 public:
+    // Most slot IDs one addSlotRange call may cover; the merged slot list is
+    // allocated up front, so an unbounded range could exhaust memory
+    static constexpr long long kMaxSlotRange = 1 << 20;
+
+    // Forward iterator over slots in ID order. It keeps the stack of pending
+    // ancestors instead of recursing, so results can be streamed lazily.
+    // Any change to the tree invalidates it.
+    class const_iterator {
+    private:
+        vector<const BSTNode*> stack;   // Top is the current slot
+
+        void pushLeftSpine(const BSTNode* node) {
+            while (node) {
+                stack.push_back(node);
+                node = node->left;
+            }
+        }
+
+        friend class EVSlotBST;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef BSTNode value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const BSTNode* pointer;
+        typedef const BSTNode& reference;
+
+        reference operator*() const { return *stack.back(); }
+        pointer operator->() const { return stack.back(); }
+
+        const_iterator& operator++() {
+            const BSTNode* node = stack.back();
+            stack.pop_back();
+            pushLeftSpine(node->right);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return (stack.empty() ? nullptr : stack.back()) == (other.stack.empty() ? nullptr : other.stack.back());
+        }
+
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    // Iterator pair usable in a range-based for loop
+    struct SlotRange {
+        const_iterator first, last;
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+    };
+
+    const_iterator begin() const {
+        const_iterator it;
+        it.pushLeftSpine(root);
+        return it;
+    }
+
+    const_iterator end() const { return const_iterator(); }
+
+    // First slot with ID >= slotID
+    const_iterator lowerBound(int slotID) const {
+        const_iterator it;
+        for (const BSTNode* node = root; node;) {
+            if (node->slotID >= slotID) {
+                it.stack.push_back(node);
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return it;
+    }
+
+    // First slot with ID > slotID
+    const_iterator upperBound(int slotID) const {
+        const_iterator it;
+        for (const BSTNode* node = root; node;) {
+            if (node->slotID > slotID) {
+                it.stack.push_back(node);
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return it;
+    }
+
+    // Slots with IDs in [lo, hi], in ID order
+    SlotRange range(int lo, int hi) const {
+        if (lo > hi) return {end(), end()};
+        return {lowerBound(lo), upperBound(hi)};
+    }
+
     EVSlotBST() : root(nullptr) {}
 
+    // Bulk-build a perfectly balanced tree from slot IDs in O(n) (O(n log n) if unsorted)
+    explicit EVSlotBST(vector<int> slotIDs) : root(nullptr) {
+        if (!is_sorted(slotIDs.begin(), slotIDs.end())) sort(slotIDs.begin(), slotIDs.end());
+        slotIDs.erase(unique(slotIDs.begin(), slotIDs.end()), slotIDs.end());
+        vector<SlotState> slots;
+        slots.reserve(slotIDs.size());
+        for (int slotID : slotIDs) slots.push_back({slotID, true});
+        rebuild(slots);
+        resetSchedules(slots);
+    }
+
+    // Nodes point into nodeBlocks, so the tree cannot be copied
+    EVSlotBST(const EVSlotBST&) = delete;
+    EVSlotBST& operator=(const EVSlotBST&) = delete;
+
+    // Recover the slots from the journal at basePath, then log every later
+    // change to it. Returns false if the journal cannot be opened.
+    bool attachJournal(SlotStateLog& log, const string& basePath) {
+        bool opened = log.open(basePath,
+                               [this](const string& bytes) { restore(bytes); },
+                               [this](const string& record) { replayChange(record); });
+        if (opened) journal = &log;
+        return opened;
+    }
+
+    // Block until every journaled change so far is on disk. This is the
+    // acknowledgement point for the changes since the last call, which are
+    // only queued when made so a batch shares one flush. Returns false if
+    // any of them could not be saved (they stay applied in memory).
+    bool waitDurable() {
+        if (!journal || acknowledgedSeq == loggedSeq) return true;
+        acknowledgedSeq = loggedSeq;
+        return journal->waitDurable(loggedSeq);
+    }
+
     // Insert a new charging slot
     void addSlot(int slotID) {
+        bool exists = findSlot(root, slotID) != nullptr;
         root = insertSlot(root, slotID);
+        if (!exists) logChange('A', slotID);
         cout << "Slot " << slotID << " added successfully.\n";
     }
 
+    // Add every slot ID in [lo, hi]; existing slots keep their state. Large
+    // ranges are merged with the current slots and the tree is rebuilt in
+    // O(n + m); small ones are inserted individually. Returns the number
+    // added, or -1 without changing anything if the range covers more than
+    // kMaxSlotRange IDs.
+    long long addSlotRange(int lo, int hi) {
+        if (lo > hi) return 0;
+        long long rangeSize = (long long)hi - lo + 1;
+        if (rangeSize > kMaxSlotRange) return -1;
+        long long before = slotCount();
+
+        if (rangeSize * 16 < before) {
+            for (long long id = lo; id <= hi; id++) {
+                if (!findSlot(root, (int)id)) root = insertSlot(root, (int)id);
+            }
+        } else {
+            vector<SlotState> existing = collectSlots();
+            vector<SlotState> merged;
+            merged.reserve(existing.size() + rangeSize);
+            size_t i = 0;
+            for (long long id = lo; id <= hi; id++) {
+                while (i < existing.size() && existing[i].slotID < id) merged.push_back(existing[i++]);
+                if (i < existing.size() && existing[i].slotID == id) {
+                    merged.push_back(existing[i++]);
+                } else {
+                    merged.push_back({(int)id, true});
+                }
+            }
+            while (i < existing.size()) merged.push_back(existing[i++]);
+            rebuild(merged);
+            lock_guard<mutex> lock(scheduleLock);
+            schedules.addSlots(lo, hi);
+        }
+        long long added = (long long)slotCount() - before;
+        if (added > 0) logChange('R', lo, hi);
+        return added;
+    }
+
+    // Remove every slot with ID in [lo, hi] and rebuild the remaining tree in
+    // O(n). Returns the number of slots removed.
+    long long removeSlotRange(int lo, int hi) {
+        if (lo > hi) return 0;
+        vector<SlotState> slots = collectSlots();
+        auto first = lower_bound(slots.begin(), slots.end(), lo,
+                                 [](const SlotState& slot, int id) { return slot.slotID < id; });
+        auto last = upper_bound(slots.begin(), slots.end(), hi,
+                                [](int id, const SlotState& slot) { return id < slot.slotID; });
+        long long removed = last - first;
+        if (removed == 0) return 0;
+        {
+            lock_guard<mutex> lock(scheduleLock);
+            schedules.removeSlots(lo, hi);
+        }
+        slots.erase(first, last);
+        rebuild(slots);
+        logChange('X', lo, hi);
+        return removed;
+    }
+
     // Allocate a slot to an EV
     void allocateSlot(int slotID) {
         BSTNode* slot = findSlot(root, slotID);
@@ -67,7 +493,8 @@ public:
             return;
         }
         if (slot->isAvailable) {
-            slot->isAvailable = false;
+            setAvailability(slotID, false);
+            logChange('O', slotID);
             cout << "Slot " << slotID << " allocated successfully.\n";
         } else {
             cout << "Slot " << slotID << " is already occupied.\n";
@@ -82,7 +509,8 @@ public:
             return;
         }
         if (!slot->isAvailable) {
-            slot->isAvailable = true;
+            setAvailability(slotID, true);
+            logChange('F', slotID);
             cout << "Slot " << slotID << " deallocated successfully.\n";
         } else {
             cout << "Slot " << slotID << " is already available.\n";
@@ -90,24 +518,414 @@ public:
     }
 
     // Display all slots in the system
-    void displaySlots() {
+    void displaySlots() const {
         cout << "\nAll Charging Slots:\n";
-        displaySlots(root);
+        for (const BSTNode& slot : *this) {
+            cout << "Slot ID: " << slot.slotID
+                 << " | Availability: " << (slot.isAvailable ? "Available" : "Occupied") << endl;
+        }
+    }
+
+    // Display the slots with IDs in [lo, hi]
+    void displaySlots(int lo, int hi) const {
+        cout << "\nCharging Slots " << lo << " to " << hi << ":\n";
+        for (const BSTNode& slot : range(lo, hi)) {
+            cout << "Slot ID: " << slot.slotID
+                 << " | Availability: " << (slot.isAvailable ? "Available" : "Occupied") << endl;
+        }
+    }
+
+    // slotID receives the k-th free slot in ID order (1-based); false if
+    // there are fewer than k. Any int is a valid slot ID, so there is no sentinel.
+    bool kthFree(int k, int& slotID) const {
+        if (k < 1 || k > freeCount(root)) return false;
+        BSTNode* node = root;
+        while (node) {
+            int leftFree = freeCount(node->left);
+            if (k <= leftFree) {
+                node = node->left;
+                continue;
+            }
+            k -= leftFree;
+            if (node->isAvailable) {
+                if (k == 1) {
+                    slotID = node->slotID;
+                    return true;
+                }
+                k--;
+            }
+            node = node->right;
+        }
+        return false;
+    }
+
+    // Number of free slots with IDs in [lo, hi]
+    int countFree(int lo, int hi) const {
+        if (lo > hi) return 0;
+        return countFreeBelow(hi, true) - countFreeBelow(lo, false);
+    }
+
+    // nearest receives the free slot whose ID is closest to slotID (lower ID
+    // wins ties); false if no slot is free
+    bool nearestFree(int slotID, int& nearest) const {
+        int lower = 0, upper = 0;
+        bool hasLower = kthFree(countFreeBelow(slotID, true), lower);
+        bool hasUpper = kthFree(countFreeBelow(slotID, false) + 1, upper);
+        if (!hasLower && !hasUpper) return false;
+        nearest = !hasUpper || (hasLower && (long long)slotID - lower <= (long long)upper - slotID) ? lower : upper;
+        return true;
+    }
+
+    // Allocate the free slot with the smallest ID in [lo, hi]; slotID
+    // receives it. False if none is free.
+    bool allocateFirstFreeInRange(int lo, int hi, int& slotID) {
+        if (lo > hi || !kthFree(countFreeBelow(lo, false) + 1, slotID) || slotID > hi) return false;
+        setAvailability(slotID, false);
+        logChange('O', slotID);
+        return true;
+    }
+
+    // Book slotID for [start, end). Fails if the slot does not exist or the
+    // window overlaps one of its bookings.
+    bool reserveSlot(int slotID, long long start, long long end) {
+        lock_guard<mutex> lock(scheduleLock);
+        return schedules.book(slotID, start, end);
+    }
+
+    // Find a slot free for [start, end) and book it in one step; slotID
+    // receives its ID. False if no slot is free for the window. The best fit
+    // wins: the slot whose free gap around the window starts latest, lowest
+    // ID on ties. O(log g) for g free gaps.
+    bool reserveAnySlot(long long start, long long end, int& slotID) {
+        lock_guard<mutex> lock(scheduleLock);
+        return schedules.bookAny(start, end, slotID);
+    }
+
+    // Cancel the booking [start, end) on slotID
+    bool cancelReservation(int slotID, long long start, long long end) {
+        lock_guard<mutex> lock(scheduleLock);
+        return schedules.cancel(slotID, start, end);
+    }
+
+    // Earliest start >= from of a session of the given length on any slot;
+    // slotID receives the best-fit slot at that time. False if there are no slots.
+    bool earliestStart(long long from, long long duration, long long& start, int& slotID) const {
+        lock_guard<mutex> lock(scheduleLock);
+        return schedules.earliestStart(from, duration, start, slotID);
+    }
+};
+
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its whitespace-separated arguments ('#' starts a comment line).
+// --generate writes a random trace; --replay runs a trace through a naive
+// reference and through EVSlotBST, times both and reports the first answer
+// that differs, so a change to the tree is checked for speed and correctness
+// in one run.
+//
+//   A id           add slot                  O id / F id    occupy / free slot
+//   R lo hi        add range (-> added)      X lo hi        remove range (-> removed)
+//   K k            k-th free slot            C lo hi        free slots in range
+//   N id           nearest free slot         G lo hi        allocate first free in range
+//   B id s e       reserve slot (-> 0/1)     Y s e          reserve any slot (-> ID)
+//   Z id s e       cancel reservation        E from len     earliest start (-> time slot)
+//
+// A query with no answer (no such slot, or no slot free) answers "none"; an
+// R covering more than EVSlotBST::kMaxSlotRange IDs answers -1.
+
+// Reference for EVSlotBST: an ordered map and plain booking lists; free-slot
+// and booking queries are answered by linear scans
+class ReferenceSlots {
+private:
+    map<int, bool> slots;   // ID -> available
+    map<int, vector<pair<long long, long long>>> bookings;
+
+    bool windowFree(int slotID, long long start, long long end) const {
+        auto it = bookings.find(slotID);
+        if (it == bookings.end()) return true;
+        for (const auto& booking : it->second) {
+            if (booking.first < end && start < booking.second) return false;
+        }
+        return true;
+    }
+
+    // Free slot whose gap around [start, end) starts latest, lowest ID on
+    // ties; a slot with no booking before the window ranks last. False if none.
+    bool bestFit(long long start, long long end, int& bestSlot) const {
+        bool found = false;
+        long long bestGap = LLONG_MIN;
+        for (const auto& slot : slots) {
+            if (!windowFree(slot.first, start, end)) continue;
+            long long gapStart = LLONG_MIN;
+            auto booked = bookings.find(slot.first);
+            if (booked != bookings.end()) {
+                for (const auto& booking : booked->second) {
+                    if (booking.second <= start) gapStart = max(gapStart, booking.second);
+                }
+            }
+            if (!found || gapStart > bestGap) {
+                found = true;
+                bestSlot = slot.first;
+                bestGap = gapStart;
+            }
+        }
+        return found;
+    }
+
+public:
+    string apply(const TraceOp& op) {
+        auto num = [&](size_t i) { return stoll(op.args.at(i)); };
+        switch (op.op) {
+        case 'A': slots.emplace((int)num(0), true); return "";
+        case 'O': case 'F': {
+            auto it = slots.find((int)num(0));
+            if (it != slots.end()) it->second = op.op == 'F';
+            return "";
+        }
+        case 'R': {
+            if (num(1) - num(0) + 1 > EVSlotBST::kMaxSlotRange) return "-1";
+            long long added = 0;
+            for (long long id = num(0); id <= num(1); id++) added += slots.emplace((int)id, true).second;
+            return to_string(added);
+        }
+        case 'X': {
+            long long removed = 0;
+            for (auto it = slots.lower_bound((int)num(0)); it != slots.end() && it->first <= num(1); removed++) {
+                bookings.erase(it->first);
+                it = slots.erase(it);
+            }
+            return to_string(removed);
+        }
+        case 'K': {
+            long long k = num(0);
+            for (const auto& slot : slots) {
+                if (slot.second && --k == 0) return to_string(slot.first);
+            }
+            return "none";
+        }
+        case 'C': {
+            int count = 0;
+            for (auto it = slots.lower_bound((int)num(0)); it != slots.end() && it->first <= num(1); ++it) {
+                count += it->second;
+            }
+            return to_string(count);
+        }
+        case 'N': {
+            long long target = num(0), best = 0;
+            bool any = false;
+            for (const auto& slot : slots) {
+                if (slot.second && (!any || llabs(slot.first - target) < llabs(best - target))) best = slot.first;
+                any = any || slot.second;
+            }
+            return any ? to_string(best) : "none";
+        }
+        case 'G':
+            for (auto it = slots.lower_bound((int)num(0)); it != slots.end() && it->first <= num(1); ++it) {
+                if (it->second) {
+                    it->second = false;
+                    return to_string(it->first);
+                }
+            }
+            return "none";
+        case 'B': {
+            int slotID = (int)num(0);
+            if (num(1) >= num(2) || !slots.count(slotID) || !windowFree(slotID, num(1), num(2))) return "0";
+            bookings[slotID].push_back({num(1), num(2)});
+            return "1";
+        }
+        case 'Y': {
+            int slotID;
+            if (num(0) >= num(1) || !bestFit(num(0), num(1), slotID)) return "none";
+            bookings[slotID].push_back({num(0), num(1)});
+            return to_string(slotID);
+        }
+        case 'Z': {
+            auto it = bookings.find((int)num(0));
+            if (it == bookings.end()) return "0";
+            auto match = find(it->second.begin(), it->second.end(), make_pair(num(1), num(2)));
+            if (match == it->second.end()) return "0";
+            it->second.erase(match);
+            return "1";
+        }
+        case 'E': {
+            long long best = num(0);
+            bool any = false;
+            for (const auto& slot : slots) {
+                long long t = num(0);
+                auto booked = bookings.find(slot.first);
+                for (bool moved = booked != bookings.end(); moved;) {
+                    moved = false;
+                    for (const auto& booking : booked->second) {
+                        if (booking.first < t + num(1) && t < booking.second) {
+                            t = booking.second;
+                            moved = true;
+                        }
+                    }
+                }
+                if (!any || t < best) best = t;
+                any = true;
+            }
+            int slotID;
+            if (!any || !bestFit(best, best + num(1), slotID)) return "none";
+            return to_string(best) + " " + to_string(slotID);
+        }
+        }
+        return "";
     }
 };
 
+// Answer one trace op with EVSlotBST
+string applyToTree(EVSlotBST& tree, const TraceOp& op) {
+    auto num = [&](size_t i) { return stoll(op.args.at(i)); };
+    switch (op.op) {
+    case 'A': tree.addSlot((int)num(0)); return "";
+    case 'O': tree.allocateSlot((int)num(0)); return "";
+    case 'F': tree.deallocateSlot((int)num(0)); return "";
+    case 'R': return to_string(tree.addSlotRange((int)num(0), (int)num(1)));
+    case 'X': return to_string(tree.removeSlotRange((int)num(0), (int)num(1)));
+    case 'K': {
+        int slotID;
+        return tree.kthFree((int)num(0), slotID) ? to_string(slotID) : "none";
+    }
+    case 'C': return to_string(tree.countFree((int)num(0), (int)num(1)));
+    case 'N': {
+        int slotID;
+        return tree.nearestFree((int)num(0), slotID) ? to_string(slotID) : "none";
+    }
+    case 'G': {
+        int slotID;
+        return tree.allocateFirstFreeInRange((int)num(0), (int)num(1), slotID) ? to_string(slotID) : "none";
+    }
+    case 'B': return tree.reserveSlot((int)num(0), num(1), num(2)) ? "1" : "0";
+    case 'Y': {
+        int slotID;
+        return tree.reserveAnySlot(num(0), num(1), slotID) ? to_string(slotID) : "none";
+    }
+    case 'Z': return tree.cancelReservation((int)num(0), num(1), num(2)) ? "1" : "0";
+    case 'E': {
+        int slotID;
+        long long start;
+        if (!tree.earliestStart(num(0), num(1), start, slotID)) return "none";
+        return to_string(start) + " " + to_string(slotID);
+    }
+    }
+    return "";
+}
+
+// Write a random trace of the given length over slot IDs [-idSpace / 8, idSpace);
+// negative IDs are valid slots too, so none of them may double as "no slot"
+bool generateSlotTrace(const string& path, long long operations, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    int idSpace = (int)max(64LL, operations / 8);
+    auto id = [&]() { return (int)(rng() % (idSpace + idSpace / 8)) - idSpace / 8; };
+    auto range = [&](int maxLength) {
+        int lo = id();
+        return to_string(lo) + " " + to_string(lo + (int)(rng() % maxLength));
+    };
+    auto window = [&]() {
+        long long start = rng() % 10000;
+        return to_string(start) + " " + to_string(start + 1 + rng() % 240);
+    };
+
+    out << "# EVSlotBST trace, seed " << seed << "\n";
+    for (long long i = 0; i < operations; i++) {
+        switch (rng() % 20) {
+        case 0: case 1: case 2: out << "A " << id() << "\n"; break;
+        case 3: case 4: out << "O " << id() << "\n"; break;
+        case 5: case 6: out << "F " << id() << "\n"; break;
+        case 7:
+            if (rng() % 64) {
+                out << "R " << range(64) << "\n";
+            } else {   // Over the limit: must be rejected without allocating
+                int lo = id();
+                long long hi = lo + EVSlotBST::kMaxSlotRange + rng() % (INT_MAX - lo - EVSlotBST::kMaxSlotRange);
+                out << "R " << lo << " " << hi << "\n";
+            }
+            break;
+        case 8: out << "X " << range(16) << "\n"; break;
+        case 9: out << "K " << 1 + rng() % (idSpace / 2) << "\n"; break;
+        case 10: case 11: out << "C " << range(idSpace / 4) << "\n"; break;
+        case 12: out << "N " << id() << "\n"; break;
+        case 13: out << "G " << range(32) << "\n"; break;
+        case 14: case 15: out << "B " << id() << " " << window() << "\n"; break;
+        case 16: out << "Y " << window() << "\n"; break;
+        case 17: out << "Z " << id() << " " << window() << "\n"; break;
+        default: out << "E " << rng() % 10000 << " " << 1 + rng() % 240 << "\n"; break;
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and EVSlotBST; returns the exit code
+int replaySlotTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    try {
+        vector<string> expected, answers;
+        ReferenceSlots reference;
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return reference.apply(op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        EVSlotBST tree;
+        {
+            QuietOutput quiet;
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToTree(tree, op); });
+        }
+        return reportRun("EVSlotBST", trace, seconds, answers, &expected) ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> [seed]
+    //   --replay <trace>
+    if (argc >= 4 && string(argv[1]) == "--generate") {
+        if (!generateSlotTrace(argv[2], atoll(argv[3]), argc >= 5 ? (unsigned)atoi(argv[4]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replaySlotTrace(argv[2]);
+    }
+
     EVSlotBST evSlots;
+    SlotStateLog journal;
     int choice, slotID;
 
+    if (evSlots.attachJournal(journal, "ev_slots")) {
+        cout << "Recovered " << evSlots.countFree(INT_MIN, INT_MAX) << " free slots from the journal.\n";
+    } else {
+        cout << "Warning: slot journal unavailable; changes will not survive a restart.\n";
+    }
+
     while (true) {
         cout << "\nEV Charging Slot Management Menu:\n";
         cout << "1. Add Charging Slot\n";
         cout << "2. Allocate Slot to EV\n";
         cout << "3. Deallocate Slot\n";
         cout << "4. Display All Slots\n";
-        cout << "5. Exit\n";
+        cout << "5. Find Nearest Free Slot\n";
+        cout << "6. Count Free Slots in Range\n";
+        cout << "7. Allocate First Free Slot in Range\n";
+        cout << "8. Find k-th Free Slot\n";
+        cout << "9. Add Range of Charging Slots\n";
+        cout << "10. Remove Range of Charging Slots\n";
+        cout << "11. Display Slots in Range\n";
+        cout << "12. Reserve Slot for Time Window\n";
+        cout << "13. Reserve Any Slot for Time Window\n";
+        cout << "14. Cancel Reservation\n";
+        cout << "15. Find Earliest Start for Session\n";
+        cout << "16. Exit\n";
         cout << "Enter your choice: ";
         cin >> choice;
 
@@ -130,11 +948,126 @@ int main() {
         case 4:
             evSlots.displaySlots();
             break;
-        case 5:
+        case 5: {
+            cout << "Enter Slot ID to search near: ";
+            cin >> slotID;
+            int nearest;
+            if (!evSlots.nearestFree(slotID, nearest)) {
+                cout << "No free slots available.\n";
+            } else {
+                cout << "Nearest free slot to " << slotID << ": " << nearest << endl;
+            }
+            break;
+        }
+        case 6: {
+            int lo, hi;
+            cout << "Enter Slot ID range (low high): ";
+            cin >> lo >> hi;
+            cout << "Free slots between " << lo << " and " << hi << ": " << evSlots.countFree(lo, hi) << endl;
+            break;
+        }
+        case 7: {
+            int lo, hi;
+            cout << "Enter Slot ID range (low high): ";
+            cin >> lo >> hi;
+            int allocated;
+            if (!evSlots.allocateFirstFreeInRange(lo, hi, allocated)) {
+                cout << "No free slot between " << lo << " and " << hi << ".\n";
+            } else {
+                cout << "Slot " << allocated << " allocated successfully.\n";
+            }
+            break;
+        }
+        case 8: {
+            int k;
+            cout << "Enter k: ";
+            cin >> k;
+            int slot;
+            if (!evSlots.kthFree(k, slot)) {
+                cout << "There are fewer than " << k << " free slots.\n";
+            } else {
+                cout << "Free slot #" << k << ": " << slot << endl;
+            }
+            break;
+        }
+        case 9: {
+            int lo, hi;
+            cout << "Enter Slot ID range to add (low high): ";
+            cin >> lo >> hi;
+            long long added = evSlots.addSlotRange(lo, hi);
+            if (added < 0)
+                cout << "Error: a range may add at most " << EVSlotBST::kMaxSlotRange << " slots at once.\n";
+            else
+                cout << added << " slots added between " << lo << " and " << hi << ".\n";
+            break;
+        }
+        case 10: {
+            int lo, hi;
+            cout << "Enter Slot ID range to remove (low high): ";
+            cin >> lo >> hi;
+            long long removed = evSlots.removeSlotRange(lo, hi);
+            cout << removed << " slots removed between " << lo << " and " << hi << ".\n";
+            break;
+        }
+        case 11: {
+            int lo, hi;
+            cout << "Enter Slot ID range to display (low high): ";
+            cin >> lo >> hi;
+            evSlots.displaySlots(lo, hi);
+            break;
+        }
+        case 12: {
+            long long start, end;
+            cout << "Enter Slot ID: ";
+            cin >> slotID;
+            cout << "Enter time window in minutes (start end): ";
+            cin >> start >> end;
+            if (evSlots.reserveSlot(slotID, start, end))
+                cout << "Slot " << slotID << " reserved for [" << start << ", " << end << ").\n";
+            else
+                cout << "Slot " << slotID << " cannot be reserved for that window.\n";
+            break;
+        }
+        case 13: {
+            long long start, end;
+            cout << "Enter time window in minutes (start end): ";
+            cin >> start >> end;
+            int reserved;
+            if (!evSlots.reserveAnySlot(start, end, reserved))
+                cout << "No slot is free for that window.\n";
+            else
+                cout << "Slot " << reserved << " reserved for [" << start << ", " << end << ").\n";
+            break;
+        }
+        case 14: {
+            long long start, end;
+            cout << "Enter Slot ID: ";
+            cin >> slotID;
+            cout << "Enter reserved window in minutes (start end): ";
+            cin >> start >> end;
+            if (evSlots.cancelReservation(slotID, start, end))
+                cout << "Reservation cancelled.\n";
+            else
+                cout << "No such reservation.\n";
+            break;
+        }
+        case 15: {
+            long long from, duration;
+            cout << "Enter earliest acceptable start and session length in minutes: ";
+            cin >> from >> duration;
+            long long start;
+            if (!evSlots.earliestStart(from, duration, start, slotID))
+                cout << "No charging slots exist.\n";
+            else
+                cout << "Earliest start: " << start << " on slot " << slotID << ".\n";
+            break;
+        }
+        case 16:
             cout << "Exiting EV Charging Slot Management System. Goodbye!\n";
             return 0;
         default:
             cout << "Invalid choice. Please try again.\n";
         }
+        if (!evSlots.waitDurable()) cout << "Error: slot changes could not be saved to the journal.\n";
     }
 }
@@ -1,23 +1,337 @@
 #include <iostream>
-#include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstring>
 #include <limits>  // To clear input buffer
+#include <mutex>
+#include <shared_mutex>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>  // SSE2 intrinsics for control-byte matching
+#endif
+
+#include "trace_harness.h"
 
 using namespace std;
 
-// HashMap to store segment metadata
-unordered_map<int, string> segmentMetadata;
+// Mix a segment ID into a well-spread 64-bit hash
+inline uint64_t hashSegmentID(int segmentID) {
+    uint64_t h = static_cast<uint32_t>(segmentID) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+// Open-addressing flat hash map for segment metadata (SwissTable layout).
+// Slots are stored in one contiguous array split into groups of 16; each slot
+// has a control byte holding 7 bits of its hash (or kEmpty), so a lookup scans
+// a whole group with one SIMD compare and usually touches a single slot.
+// Names are kept in one shared arena instead of a heap string per entry.
+class SegmentMetadataStore {
+private:
+    static const size_t kGroupWidth = 16;
+    static const int8_t kEmpty = -128;
+    static const size_t kNotFound = numeric_limits<size_t>::max();
+
+    struct Slot {
+        int segmentID;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    vector<int8_t> ctrl;        // One control byte per slot
+    vector<Slot> slots;         // Capacity is a power of two, multiple of kGroupWidth
+    string nameArena;           // Concatenated segment names
+    size_t numEntries = 0;
+    size_t arenaGarbage = 0;    // Arena bytes no longer referenced by any slot
+
+    // Bitmask of the slots in a group whose control byte equals tag
+    static uint32_t matchGroup(const int8_t* group, int8_t tag) {
+#if defined(__SSE2__)
+        __m128i ctrlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8(tag))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            if (group[i] == tag) mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    static int lowestBit(uint32_t mask) {
+        int bit = 0;
+        while (!(mask & 1u)) {
+            mask >>= 1;
+            bit++;
+        }
+        return bit;
+    }
+
+    static int8_t tagOf(uint64_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    // Locate the slot holding segmentID, or kNotFound
+    size_t findSlot(int segmentID, uint64_t hash) const {
+        if (slots.empty()) return kNotFound;
+
+        size_t groupMask = slots.size() / kGroupWidth - 1;
+        size_t group = (hash >> 7) & groupMask;
+        for (size_t step = 1;; step++) {
+            const int8_t* ctrlGroup = &ctrl[group * kGroupWidth];
+            for (uint32_t m = matchGroup(ctrlGroup, tagOf(hash)); m; m &= m - 1) {
+                size_t index = group * kGroupWidth + lowestBit(m);
+                if (slots[index].segmentID == segmentID) return index;
+            }
+            // An empty slot in the group ends the probe sequence (no deletions)
+            if (matchGroup(ctrlGroup, kEmpty)) return kNotFound;
+            group = (group + step) & groupMask;  // Triangular probing visits every group
+        }
+    }
+
+    // Claim the first empty slot on segmentID's probe sequence
+    size_t claimSlot(uint64_t hash) {
+        size_t groupMask = slots.size() / kGroupWidth - 1;
+        size_t group = (hash >> 7) & groupMask;
+        for (size_t step = 1;; step++) {
+            uint32_t empties = matchGroup(&ctrl[group * kGroupWidth], kEmpty);
+            if (empties) {
+                size_t index = group * kGroupWidth + lowestBit(empties);
+                ctrl[index] = tagOf(hash);
+                return index;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    uint32_t appendName(string_view name) {
+        uint32_t offset = static_cast<uint32_t>(nameArena.size());
+        nameArena.append(name.data(), name.size());
+        return offset;
+    }
+
+    // Reallocate to newCapacity slots, copying live names into a fresh arena
+    void rehash(size_t newCapacity) {
+        vector<int8_t> oldCtrl(newCapacity, kEmpty);
+        vector<Slot> oldSlots(newCapacity);
+        string oldArena;
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        oldArena.swap(nameArena);
+        nameArena.reserve(oldArena.size() - arenaGarbage);
+        arenaGarbage = 0;
+
+        for (size_t i = 0; i < oldSlots.size(); i++) {
+            if (oldCtrl[i] == kEmpty) continue;
+            const Slot& old = oldSlots[i];
+            Slot& slot = slots[claimSlot(hashSegmentID(old.segmentID))];
+            slot.segmentID = old.segmentID;
+            slot.nameOffset = appendName(string_view(oldArena).substr(old.nameOffset, old.nameLength));
+            slot.nameLength = old.nameLength;
+        }
+    }
+
+    // Smallest capacity that keeps n entries under the 7/8 load factor
+    static size_t capacityFor(size_t n) {
+        size_t capacity = kGroupWidth;
+        while (capacity - capacity / 8 < n) capacity *= 2;
+        return capacity;
+    }
+
+public:
+    // Make room for n entries without further rehashing
+    void reserve(size_t n) {
+        size_t capacity = capacityFor(n);
+        if (capacity > slots.size()) rehash(capacity);
+    }
+
+    // Insert or overwrite a segment's name; returns true if the segment is new
+    bool update(int segmentID, string_view name) {
+        uint64_t hash = hashSegmentID(segmentID);
+        size_t index = findSlot(segmentID, hash);
+        if (index != kNotFound) {
+            Slot& slot = slots[index];
+            if (name.size() <= slot.nameLength) {
+                memcpy(&nameArena[slot.nameOffset], name.data(), name.size());
+                arenaGarbage += slot.nameLength - name.size();
+            } else {
+                arenaGarbage += slot.nameLength;
+                slot.nameOffset = appendName(name);
+            }
+            slot.nameLength = static_cast<uint32_t>(name.size());
+            if (arenaGarbage > nameArena.size() / 2) rehash(slots.size());
+            return false;
+        }
+
+        reserve(numEntries + 1);
+        Slot& slot = slots[claimSlot(hash)];
+        slot.segmentID = segmentID;
+        slot.nameOffset = appendName(name);
+        slot.nameLength = static_cast<uint32_t>(name.size());
+        numEntries++;
+        return true;
+    }
+
+    // Load many entries at once, sizing the table and arena up front
+    void bulkLoad(const vector<pair<int, string>>& entries) {
+        size_t totalLength = 0;
+        for (const auto& entry : entries) totalLength += entry.second.size();
+        reserve(numEntries + entries.size());
+        nameArena.reserve(nameArena.size() + totalLength);
+        for (const auto& entry : entries) {
+            update(entry.first, entry.second);
+        }
+    }
+
+    // Look up a segment's name with a single probe; the view stays valid
+    // until the store is next modified
+    bool find(int segmentID, string_view& name) const {
+        size_t index = findSlot(segmentID, hashSegmentID(segmentID));
+        if (index == kNotFound) return false;
+        name = string_view(nameArena).substr(slots[index].nameOffset, slots[index].nameLength);
+        return true;
+    }
+
+    // Visit every (segmentID, name) pair in slot order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (ctrl[i] == kEmpty) continue;
+            visit(slots[i].segmentID, string_view(nameArena).substr(slots[i].nameOffset, slots[i].nameLength));
+        }
+    }
+
+    size_t size() const { return numEntries; }
+    bool empty() const { return numEntries == 0; }
+};
+
+// Segment metadata store shared by many threads. Entries are sharded by the
+// top bits of the segment ID hash (each shard's flat table probes with the low
+// bits) and every shard has its own reader-writer lock, so readers never block
+// each other and writers only block their own shard.
+class ConcurrentSegmentMetadataStore {
+private:
+    static const size_t kNumShards = 64;
+
+    struct alignas(64) Shard {  // One cache line apart to avoid false sharing of locks
+        mutable shared_mutex lock;
+        SegmentMetadataStore store;
+    };
+
+    Shard shards[kNumShards];
+
+    static size_t shardOf(int segmentID) {
+        return hashSegmentID(segmentID) >> 58;  // Top 6 bits select one of 64 shards
+    }
+
+    // Group item positions by shard so each shard is locked once per batch
+    template <typename KeyOf>
+    static void groupByShard(size_t count, KeyOf keyOf, vector<size_t>& shardStart, vector<size_t>& order) {
+        shardStart.assign(kNumShards + 1, 0);
+        for (size_t i = 0; i < count; i++) shardStart[shardOf(keyOf(i)) + 1]++;
+        for (size_t s = 0; s < kNumShards; s++) shardStart[s + 1] += shardStart[s];
+        order.resize(count);
+        vector<size_t> next(shardStart.begin(), shardStart.end() - 1);
+        for (size_t i = 0; i < count; i++) order[next[shardOf(keyOf(i))]++] = i;
+    }
+
+public:
+    // Insert or overwrite a segment's name; returns true if the segment is new
+    bool update(int segmentID, string_view name) {
+        Shard& shard = shards[shardOf(segmentID)];
+        unique_lock<shared_mutex> guard(shard.lock);
+        return shard.store.update(segmentID, name);
+    }
+
+    // Copy a segment's name out under a shared lock
+    bool find(int segmentID, string& name) const {
+        const Shard& shard = shards[shardOf(segmentID)];
+        shared_lock<shared_mutex> guard(shard.lock);
+        string_view view;
+        if (!shard.store.find(segmentID, view)) return false;
+        name.assign(view.data(), view.size());
+        return true;
+    }
+
+    // Look up a batch of segments, taking each shard's read lock once.
+    // names[i] and found[i] receive the result for segmentIDs[i].
+    void multiGet(const vector<int>& segmentIDs, vector<string>& names, vector<bool>& found) const {
+        vector<size_t> shardStart, order;
+        groupByShard(segmentIDs.size(), [&](size_t i) { return segmentIDs[i]; }, shardStart, order);
+        names.assign(segmentIDs.size(), string());
+        found.assign(segmentIDs.size(), false);
+
+        for (size_t s = 0; s < kNumShards; s++) {
+            if (shardStart[s] == shardStart[s + 1]) continue;
+            shared_lock<shared_mutex> guard(shards[s].lock);
+            for (size_t k = shardStart[s]; k < shardStart[s + 1]; k++) {
+                size_t i = order[k];
+                string_view view;
+                if (shards[s].store.find(segmentIDs[i], view)) {
+                    names[i].assign(view.data(), view.size());
+                    found[i] = true;
+                }
+            }
+        }
+    }
+
+    // Insert or overwrite a batch of segments, taking each shard's write lock once
+    void multiPut(const vector<pair<int, string>>& entries) {
+        vector<size_t> shardStart, order;
+        groupByShard(entries.size(), [&](size_t i) { return entries[i].first; }, shardStart, order);
+
+        for (size_t s = 0; s < kNumShards; s++) {
+            if (shardStart[s] == shardStart[s + 1]) continue;
+            unique_lock<shared_mutex> guard(shards[s].lock);
+            SegmentMetadataStore& store = shards[s].store;
+            store.reserve(store.size() + (shardStart[s + 1] - shardStart[s]));
+            for (size_t k = shardStart[s]; k < shardStart[s + 1]; k++) {
+                store.update(entries[order[k]].first, entries[order[k]].second);
+            }
+        }
+    }
+
+    // Visit every (segmentID, name) pair, one shard at a time
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Shard& shard : shards) {
+            shared_lock<shared_mutex> guard(shard.lock);
+            shard.store.forEach(visit);
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard& shard : shards) {
+            shared_lock<shared_mutex> guard(shard.lock);
+            total += shard.store.size();
+        }
+        return total;
+    }
+
+    bool empty() const { return size() == 0; }
+};
+
+// Store holding segment metadata, safe to share across threads
+ConcurrentSegmentMetadataStore segmentMetadata;
 
 // Function to update segment metadata
 void updateMetadataHash(int segmentID, const string& name) {
-    segmentMetadata[segmentID] = name;
+    segmentMetadata.update(segmentID, name);
     cout << "Metadata updated for segment " << segmentID << ": " << name << "\n";
 }
 
 // Function to retrieve segment metadata
 void getMetadataHash(int segmentID) {
-    if (segmentMetadata.find(segmentID) != segmentMetadata.end()) {
-        cout << "Segment " << segmentID << ": " << segmentMetadata[segmentID] << "\n";
+    string name;
+    if (segmentMetadata.find(segmentID, name)) {
+        cout << "Segment " << segmentID << ": " << name << "\n";
     } else {
         cout << "Error: Segment ID " << segmentID << " not found!\n";
     }
@@ -29,9 +343,9 @@ void displayMetadataHash() {
         cout << "No metadata available to display.\n";
     } else {
         cout << "\nSegment Metadata (Hash):\n";
-        for (const auto& entry : segmentMetadata) {
-            cout << "Segment " << entry.first << ": " << entry.second << "\n";
-        }
+        segmentMetadata.forEach([](int segmentID, string_view name) {
+            cout << "Segment " << segmentID << ": " << name << "\n";
+        });
     }
 }
 
@@ -52,18 +366,293 @@ void inputMetadata() {
     updateMetadataHash(segmentID, name);
 }
 
+// Function to handle user input for loading many segments at once
+void inputBulkMetadata() {
+    size_t count;
+    cout << "\nEnter number of segments to load: ";
+    while (!(cin >> count)) {
+        cin.clear();  // clear the error flag
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');  // discard invalid input
+        cout << "Invalid input! Please enter a valid number of segments: ";
+    }
+
+    vector<pair<int, string>> entries;
+    entries.reserve(count);
+    cout << "Enter one segment per line as: <segment ID> <name>\n";
+    while (entries.size() < count) {
+        int segmentID;
+        string name;
+        if (!(cin >> segmentID)) {
+            cin.clear();  // clear the error flag
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');  // discard invalid input
+            cout << "Invalid input! Line skipped, please enter: <segment ID> <name>\n";
+            continue;
+        }
+        getline(cin >> ws, name);
+        entries.emplace_back(segmentID, name);
+    }
+
+    segmentMetadata.multiPut(entries);
+    cout << entries.size() << " segments loaded. Store now holds " << segmentMetadata.size() << " segments.\n";
+}
+
+// Function to retrieve metadata for several segments in one batch
+void getMultipleMetadataHash() {
+    size_t count;
+    cout << "\nEnter number of segments to retrieve: ";
+    while (!(cin >> count)) {
+        cin.clear();  // clear the error flag
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');  // discard invalid input
+        cout << "Invalid input! Please enter a valid number of segments: ";
+    }
+
+    vector<int> segmentIDs;
+    segmentIDs.reserve(count);
+    cout << "Enter " << count << " segment IDs: ";
+    while (segmentIDs.size() < count) {
+        int segmentID;
+        if (!(cin >> segmentID)) {
+            cin.clear();  // clear the error flag
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');  // discard invalid input
+            cout << "Invalid input! Please enter valid integer segment IDs: ";
+            continue;
+        }
+        segmentIDs.push_back(segmentID);
+    }
+
+    vector<string> names;
+    vector<bool> found;
+    segmentMetadata.multiGet(segmentIDs, names, found);
+    for (size_t i = 0; i < segmentIDs.size(); i++) {
+        if (found[i]) {
+            cout << "Segment " << segmentIDs[i] << ": " << names[i] << "\n";
+        } else {
+            cout << "Error: Segment ID " << segmentIDs[i] << " not found!\n";
+        }
+    }
+}
+
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its arguments; names contain no whitespace. --generate writes a
+// random trace; --replay runs it through a naive reference (an ordered map)
+// and through both the single-threaded and the sharded store, times each and
+// reports the first answer that differs.
+//
+//   U id name              insert or overwrite (-> 1 if new, 0 otherwise)
+//   F id                   look up (-> name, or - if missing)
+//   M id ...               batch lookup (-> names)
+//   P id name id name ...  batch insert
+//   A                      every entry (-> count and checksum, in ID order)
+
+// Reference for the metadata stores: an ordered map, with the sharded
+// store's interface
+class ReferenceMetadata {
+private:
+    map<int, string> names;
+
+public:
+    bool update(int segmentID, string_view name) {
+        auto result = names.insert_or_assign(segmentID, string(name));
+        return result.second;
+    }
+
+    bool find(int segmentID, string& name) const {
+        auto it = names.find(segmentID);
+        if (it == names.end()) return false;
+        name = it->second;
+        return true;
+    }
+
+    void multiGet(const vector<int>& segmentIDs, vector<string>& results, vector<bool>& found) const {
+        results.assign(segmentIDs.size(), string());
+        found.assign(segmentIDs.size(), false);
+        for (size_t i = 0; i < segmentIDs.size(); i++) found[i] = find(segmentIDs[i], results[i]);
+    }
+
+    void multiPut(const vector<pair<int, string>>& entries) {
+        for (const auto& entry : entries) update(entry.first, entry.second);
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const auto& entry : names) visit(entry.first, string_view(entry.second));
+    }
+};
+
+// SegmentMetadataStore has no locking, so its batch operations are plain
+// loops and bulkLoad; the other stores answer them directly
+bool lookupName(const SegmentMetadataStore& store, int segmentID, string& name) {
+    string_view view;
+    if (!store.find(segmentID, view)) return false;
+    name.assign(view.data(), view.size());
+    return true;
+}
+
+template <typename Store>
+bool lookupName(const Store& store, int segmentID, string& name) {
+    return store.find(segmentID, name);
+}
+
+void getBatch(const SegmentMetadataStore& store, const vector<int>& segmentIDs, vector<string>& names, vector<bool>& found) {
+    names.assign(segmentIDs.size(), string());
+    found.assign(segmentIDs.size(), false);
+    for (size_t i = 0; i < segmentIDs.size(); i++) found[i] = lookupName(store, segmentIDs[i], names[i]);
+}
+
+template <typename Store>
+void getBatch(const Store& store, const vector<int>& segmentIDs, vector<string>& names, vector<bool>& found) {
+    store.multiGet(segmentIDs, names, found);
+}
+
+void putBatch(SegmentMetadataStore& store, const vector<pair<int, string>>& entries) { store.bulkLoad(entries); }
+
+template <typename Store>
+void putBatch(Store& store, const vector<pair<int, string>>& entries) {
+    store.multiPut(entries);
+}
+
+// Answer one trace op on a metadata store or the reference
+template <typename Store>
+string applyToStore(Store& store, const TraceOp& op) {
+    switch (op.op) {
+        case 'U':
+            return store.update(stoi(op.args.at(0)), op.args.at(1)) ? "1" : "0";
+        case 'F': {
+            string name;
+            return lookupName(store, stoi(op.args.at(0)), name) ? name : "-";
+        }
+        case 'M': {
+            vector<int> segmentIDs;
+            for (const string& arg : op.args) segmentIDs.push_back(stoi(arg));
+            vector<string> names;
+            vector<bool> found;
+            getBatch(store, segmentIDs, names, found);
+            for (size_t i = 0; i < names.size(); i++) {
+                if (!found[i]) names[i] = "-";
+            }
+            return joinAnswer(names);
+        }
+        case 'P': {
+            if (op.args.size() % 2) throw invalid_argument("P takes id name pairs");
+            vector<pair<int, string>> entries;
+            for (size_t i = 0; i < op.args.size(); i += 2) entries.emplace_back(stoi(op.args[i]), op.args[i + 1]);
+            putBatch(store, entries);
+            return "";
+        }
+        case 'A': {
+            vector<pair<int, string>> entries;
+            store.forEach([&](int segmentID, string_view name) { entries.emplace_back(segmentID, string(name)); });
+            sort(entries.begin(), entries.end());
+            uint64_t h = 14695981039346656037ULL;   // FNV-1a over "id=name;" in ID order
+            for (const auto& entry : entries) {
+                for (char c : to_string(entry.first) + "=" + entry.second + ";") h = (h ^ (unsigned char)c) * 1099511628211ULL;
+            }
+            return to_string(entries.size()) + " " + to_string(h);
+        }
+        default:
+            return "";
+    }
+}
+
+// Write a random trace over IDs in [-keys, keys]. Names vary in length so
+// overwrites both reuse and abandon arena space.
+bool generateMetadataTrace(const string& path, long long operations, int keys, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    auto segmentID = [&]() { return (int)(rng() % (2 * (unsigned)keys + 1)) - keys; };
+    auto name = [&]() {
+        string text(1 + rng() % 24, 'a');
+        for (char& c : text) c = (char)('a' + rng() % 26);
+        return text;
+    };
+
+    out << "# Segment metadata trace, seed " << seed << "\n";
+    for (long long i = 0; i < operations; i++) {
+        unsigned kind = rng() % 1000;
+        if (kind < 350) {
+            out << "U " << segmentID() << " " << name() << "\n";
+        } else if (kind < 800) {
+            out << "F " << segmentID() << "\n";
+        } else if (kind < 900) {
+            out << "M";
+            for (int k = 1 + rng() % 32; k > 0; k--) out << " " << segmentID();
+            out << "\n";
+        } else if (kind < 999) {
+            out << "P";
+            for (int k = 1 + rng() % 64; k > 0; k--) out << " " << segmentID() << " " << name();
+            out << "\n";
+        } else {
+            out << "A\n";
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and both stores; returns the exit code
+int replayMetadataTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    try {
+        vector<string> expected, answers;
+        ReferenceMetadata reference;
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return applyToStore(reference, op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        {
+            SegmentMetadataStore store;
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToStore(store, op); });
+            matched = reportRun("SegmentMetadataStore", trace, seconds, answers, &expected) && matched;
+        }
+        {
+            ConcurrentSegmentMetadataStore store;
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToStore(store, op); });
+            matched = reportRun("ConcurrentSegmentMetadataStore", trace, seconds, answers, &expected) && matched;
+        }
+        return matched ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
 // Function to handle the menu display and user choices
 void displayMenu() {
     cout << "\nMenu:\n";
     cout << "1. Update Segment Metadata\n";
     cout << "2. Retrieve Segment Metadata\n";
     cout << "3. Display All Segment Metadata\n";
-    cout << "4. Exit\n";
+    cout << "4. Bulk Load Segment Metadata\n";
+    cout << "5. Retrieve Multiple Segments\n";
+    cout << "6. Exit\n";
     cout << "Enter your choice: ";
 }
 
 // Main function to drive the menu options
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> <keys> [seed]
+    //   --replay <trace>
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        int keys = atoi(argv[4]);
+        if (keys < 1) {
+            cerr << "Key count must be positive.\n";
+            return 1;
+        }
+        if (!generateMetadataTrace(argv[2], atoll(argv[3]), keys, argc >= 6 ? (unsigned)atoi(argv[5]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayMetadataTrace(argv[2]);
+    }
+
     int choice;
 
     do {
@@ -73,7 +662,7 @@ int main() {
         while (!(cin >> choice)) {
             cin.clear();  // clear the error flag
             cin.ignore(numeric_limits<streamsize>::max(), '\n');  // discard invalid input
-            cout << "Invalid input! Please enter a valid menu choice (1-4): ";
+            cout << "Invalid input! Please enter a valid menu choice (1-6): ";
         }
 
         switch (choice) {
@@ -95,12 +684,18 @@ int main() {
                 displayMetadataHash();
                 break;
             case 4:
+                inputBulkMetadata();
+                break;
+            case 5:
+                getMultipleMetadataHash();
+                break;
+            case 6:
                 cout << "Exiting program...\n";
                 break;
             default:
                 cout << "Error: Invalid choice! Please try again.\n";
         }
-    } while (choice != 4);  // Repeat until the user chooses to exit
+    } while (choice != 6);  // Repeat until the user chooses to exit
 
     return 0;
 }
@@ -0,0 +1,74 @@
+#ifndef SEGMENT_ID_INTERNER_H
+#define SEGMENT_ID_INTERNER_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Dense 32-bit handle standing in for an external road segment ID
+typedef uint32_t SegmentHandle;
+const SegmentHandle kInvalidSegment = std::numeric_limits<SegmentHandle>::max();
+
+// Interning dictionary mapping external segment ID strings to dense handles.
+// A string ID is hashed once when it enters the system; everything behind it
+// indexes plain arrays by handle. Released handles are reused first so the
+// handle space stays dense and can double as the range-query index. Anything
+// that keeps a handle across a release must check isLive() or compare the
+// handle's name before trusting it, since the handle may now name another segment.
+class SegmentIDInterner {
+private:
+    std::unordered_map<std::string, SegmentHandle> handles;
+    std::vector<std::string> names;           // names[handle] is the external ID
+    std::vector<bool> live;                   // live[handle] is false once released
+    std::vector<SegmentHandle> freeHandles;   // Released handles awaiting reuse
+
+public:
+    // Return the handle for segmentID, assigning one if it is new
+    SegmentHandle intern(const std::string& segmentID, bool* added = nullptr) {
+        auto result = handles.try_emplace(segmentID, kInvalidSegment);
+        if (added) *added = result.second;
+        if (!result.second) return result.first->second;
+
+        SegmentHandle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+            names[handle] = segmentID;
+            live[handle] = true;
+        } else {
+            handle = static_cast<SegmentHandle>(names.size());
+            names.push_back(segmentID);
+            live.push_back(true);
+        }
+        result.first->second = handle;
+        return handle;
+    }
+
+    // Return the handle for segmentID, or kInvalidSegment if it was never interned
+    SegmentHandle find(const std::string& segmentID) const {
+        auto it = handles.find(segmentID);
+        return it == handles.end() ? kInvalidSegment : it->second;
+    }
+
+    // Forget a segment ID so its handle can be reassigned
+    void release(SegmentHandle handle) {
+        if (!isLive(handle)) return;
+        handles.erase(names[handle]);
+        names[handle].clear();
+        live[handle] = false;
+        freeHandles.push_back(handle);
+    }
+
+    bool isLive(SegmentHandle handle) const {
+        return handle < live.size() && live[handle];
+    }
+
+    const std::string& name(SegmentHandle handle) const { return names[handle]; }
+
+    size_t size() const { return handles.size(); }        // Live segment IDs
+    size_t handleLimit() const { return names.size(); }   // One past the highest handle issued
+};
+
+#endif
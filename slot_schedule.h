@@ -0,0 +1,388 @@
+#ifndef SLOT_SCHEDULE_H
+#define SLOT_SCHEDULE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// Future bookings of one charging slot as disjoint half-open [start, end)
+// windows (times in minutes), keyed by start so every check is O(log b)
+class SlotSchedule {
+private:
+    std::map<long long, long long> bookings;   // start -> end
+
+public:
+    // True if no booking overlaps [start, end)
+    bool isFree(long long start, long long end) const {
+        auto next = bookings.lower_bound(start);
+        if (next != bookings.end() && next->first < end) return false;
+        if (next != bookings.begin() && std::prev(next)->second > start) return false;
+        return true;
+    }
+
+    // Book [start, end) if it is free; nothing changes otherwise
+    bool book(long long start, long long end) {
+        if (start >= end || !isFree(start, end)) return false;
+        bookings.emplace(start, end);
+        return true;
+    }
+
+    // True if [start, end) is exactly one booking
+    bool hasBooking(long long start, long long end) const {
+        auto it = bookings.find(start);
+        return it != bookings.end() && it->second == end;
+    }
+
+    // Cancel the booking that is exactly [start, end)
+    bool cancel(long long start, long long end) {
+        auto it = bookings.find(start);
+        if (it == bookings.end() || it->second != end) return false;
+        bookings.erase(it);
+        return true;
+    }
+
+    // Earliest t >= from with [t, t + duration) free. Only the bookings that
+    // push t forward are visited.
+    long long earliestStart(long long from, long long duration) const {
+        long long t = from;
+        auto it = bookings.upper_bound(from);
+        if (it != bookings.begin() && std::prev(it)->second > t) t = std::prev(it)->second;
+        for (; it != bookings.end() && it->first < t + duration; ++it) {
+            t = std::max(t, it->second);
+        }
+        return t;
+    }
+
+    // The free gap [gapStart, gapEnd) around [start, end), bounded by the
+    // neighbouring bookings (LLONG_MIN / LLONG_MAX where there are none).
+    // [start, end) must be free or exactly one booking.
+    void gapAround(long long start, long long end, long long& gapStart, long long& gapEnd) const {
+        auto next = bookings.lower_bound(start);
+        gapStart = next == bookings.begin() ? LLONG_MIN : std::prev(next)->second;
+        auto after = bookings.lower_bound(end);
+        gapEnd = after == bookings.end() ? LLONG_MAX : after->first;
+    }
+
+    // Call visit(gapStart, gapEnd) for every non-empty free gap, the
+    // unbounded ones before the first and after the last booking included
+    template <typename Visitor>
+    void forEachGap(Visitor visit) const {
+        long long gapStart = LLONG_MIN;
+        for (const auto& booking : bookings) {
+            if (gapStart < booking.first) visit(gapStart, booking.first);
+            gapStart = booking.second;
+        }
+        visit(gapStart, LLONG_MAX);
+    }
+
+    bool empty() const { return bookings.empty(); }
+};
+
+// Bookings of a whole set of slots (identified by int keys), indexed so
+// that "book any slot free for [start, end)" and "earliest start of a
+// session" are answered without visiting every slot.
+//
+// Every booked slot's free gaps live in one treap ordered by gap start and
+// augmented with the subtree's largest gap end and length. Slots with no
+// bookings are free for every window and are kept as runs of keys instead,
+// so provisioning a large range costs O(log r) for r runs. With g gaps in
+// total, finding a fit or the earliest start is O(log g) expected.
+//
+// The slot chosen for a window [start, end) is the best fit: the one whose
+// free gap around the window starts latest (so the fewest minutes are left
+// stranded before it), lowest key on ties. Unbooked slots rank last.
+// Not thread-safe; the owner serializes access.
+class SlotScheduleIndex {
+private:
+    struct Gap {
+        long long start, end;   // Free over [start, end)
+        int slot;
+        uint32_t priority;
+        int left, right;
+        long long maxEnd;       // Largest end in this subtree
+        long long maxLength;    // Longest gap in this subtree
+    };
+
+    std::map<int, SlotSchedule> booked;     // Slots with at least one booking
+    std::map<long long, long long> unbooked; // Runs of unbooked keys: first -> last (inclusive)
+    std::vector<Gap> gaps;
+    std::vector<int> freeGaps;               // Recycled entries of gaps
+    int rootGap = -1;
+    uint32_t seed = 0x9E3779B9u;
+
+    static long long lengthOf(long long start, long long end) {
+        return start == LLONG_MIN || end == LLONG_MAX ? LLONG_MAX : end - start;
+    }
+
+    // Treap order: by start, then by descending key, so among gaps with the
+    // same start the rightmost belongs to the lowest key
+    static bool before(long long start, int slot, const Gap& gap) {
+        return start < gap.start || (start == gap.start && slot > gap.slot);
+    }
+
+    uint32_t nextPriority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    void pull(int t) {
+        Gap& gap = gaps[t];
+        gap.maxEnd = gap.end;
+        gap.maxLength = lengthOf(gap.start, gap.end);
+        for (int child : {gap.left, gap.right}) {
+            if (child < 0) continue;
+            gap.maxEnd = std::max(gap.maxEnd, gaps[child].maxEnd);
+            gap.maxLength = std::max(gap.maxLength, gaps[child].maxLength);
+        }
+    }
+
+    // Split t into gaps ordered before (start, slot) and the rest
+    void split(int t, long long start, int slot, int& left, int& right) {
+        if (t < 0) {
+            left = right = -1;
+            return;
+        }
+        if (before(start, slot, gaps[t])) {
+            split(gaps[t].left, start, slot, left, gaps[t].left);
+            right = t;
+        } else {
+            split(gaps[t].right, start, slot, gaps[t].right, right);
+            left = t;
+        }
+        pull(t);
+    }
+
+    int merge(int left, int right) {
+        if (left < 0) return right;
+        if (right < 0) return left;
+        if (gaps[left].priority > gaps[right].priority) {
+            gaps[left].right = merge(gaps[left].right, right);
+            pull(left);
+            return left;
+        }
+        gaps[right].left = merge(left, gaps[right].left);
+        pull(right);
+        return right;
+    }
+
+    void insertGap(long long start, long long end, int slot) {
+        if (start >= end) return;
+        int t;
+        if (freeGaps.empty()) {
+            t = (int)gaps.size();
+            gaps.emplace_back();
+        } else {
+            t = freeGaps.back();
+            freeGaps.pop_back();
+        }
+        gaps[t] = {start, end, slot, nextPriority(), -1, -1, end, lengthOf(start, end)};
+        int left, right;
+        split(rootGap, start, slot, left, right);
+        rootGap = merge(merge(left, t), right);
+    }
+
+    // Remove the gap of slot starting at start from subtree t; returns the new subtree
+    int eraseGap(int t, long long start, int slot) {
+        if (t < 0) return t;
+        Gap& gap = gaps[t];
+        if (gap.start == start && gap.slot == slot) {
+            freeGaps.push_back(t);
+            return merge(gap.left, gap.right);
+        }
+        if (before(start, slot, gap)) {
+            gap.left = eraseGap(gap.left, start, slot);
+        } else {
+            gap.right = eraseGap(gap.right, start, slot);
+        }
+        pull(t);
+        return t;
+    }
+
+    void removeGap(long long start, long long end, int slot) {
+        if (start < end) rootGap = eraseGap(rootGap, start, slot);
+    }
+
+    // Rightmost gap with start <= start and end >= end, or -1. Any subtree
+    // whose largest end is too small is skipped, so this is one descent.
+    int rightmostFit(int t, long long start, long long end) const {
+        if (t < 0 || gaps[t].maxEnd < end) return -1;
+        const Gap& gap = gaps[t];
+        if (gap.start > start) return rightmostFit(gap.left, start, end);
+        int found = rightmostFit(gap.right, start, end);
+        if (found >= 0) return found;
+        if (gap.end >= end) return t;
+        return rightmostFit(gap.left, start, end);
+    }
+
+    // Leftmost gap starting after from that is at least duration long, or -1
+    int leftmostLongEnough(int t, long long from, long long duration) const {
+        if (t < 0 || gaps[t].maxLength < duration) return -1;
+        const Gap& gap = gaps[t];
+        if (gap.start <= from) return leftmostLongEnough(gap.right, from, duration);
+        int found = leftmostLongEnough(gap.left, from, duration);
+        if (found >= 0) return found;
+        if (lengthOf(gap.start, gap.end) >= duration) return t;
+        return leftmostLongEnough(gap.right, from, duration);
+    }
+
+    // Add keys [first, last] to the unbooked runs, merging neighbours
+    void addRun(long long first, long long last) {
+        auto it = unbooked.upper_bound(first);
+        if (it != unbooked.begin() && std::prev(it)->second >= first - 1) {
+            --it;
+            first = it->first;
+            last = std::max(last, it->second);
+            it = unbooked.erase(it);
+        }
+        while (it != unbooked.end() && it->first <= last + 1) {
+            last = std::max(last, it->second);
+            it = unbooked.erase(it);
+        }
+        unbooked.emplace(first, last);
+    }
+
+    // Remove keys [first, last] from the unbooked runs
+    void removeRun(long long first, long long last) {
+        auto it = unbooked.upper_bound(first);
+        if (it != unbooked.begin()) --it;
+        while (it != unbooked.end() && it->first <= last) {
+            long long runFirst = it->first, runLast = it->second;
+            if (runLast < first) {
+                ++it;
+                continue;
+            }
+            it = unbooked.erase(it);
+            if (runFirst < first) unbooked.emplace(runFirst, first - 1);
+            if (runLast > last) {
+                unbooked.emplace(last + 1, runLast);
+                break;
+            }
+        }
+    }
+
+    bool isUnbooked(int slot) const {
+        auto it = unbooked.upper_bound(slot);
+        return it != unbooked.begin() && std::prev(it)->second >= slot;
+    }
+
+    // Best-fit slot for [start, end) as documented above; false if no slot
+    // is free then. Any int is a valid key, so there is no sentinel.
+    bool bestFit(long long start, long long end, int& slot) const {
+        int t = rightmostFit(rootGap, start, end);
+        bool anyUnbooked = !unbooked.empty();
+        int lowestUnbooked = anyUnbooked ? (int)unbooked.begin()->first : 0;
+        if (t < 0) {
+            slot = lowestUnbooked;
+            return anyUnbooked;
+        }
+        slot = gaps[t].start == LLONG_MIN && anyUnbooked && lowestUnbooked < gaps[t].slot ? lowestUnbooked : gaps[t].slot;
+        return true;
+    }
+
+public:
+    bool contains(int slot) const { return booked.count(slot) || isUnbooked(slot); }
+
+    // Add every key in [first, last] that is not already a slot
+    void addSlots(int first, int last) {
+        if (first > last) return;
+        long long next = first;
+        for (auto it = booked.lower_bound(first); it != booked.end() && it->first <= last; ++it) {
+            if (next < it->first) addRun(next, it->first - 1);
+            next = (long long)it->first + 1;
+        }
+        if (next <= last) addRun(next, last);
+    }
+
+    void addSlot(int slot) { addSlots(slot, slot); }
+
+    // Drop every slot with key in [first, last] together with its bookings
+    void removeSlots(int first, int last) {
+        if (first > last) return;
+        removeRun(first, last);
+        auto it = booked.lower_bound(first);
+        while (it != booked.end() && it->first <= last) {
+            int slot = it->first;
+            it->second.forEachGap([this, slot](long long start, long long end) { removeGap(start, end, slot); });
+            it = booked.erase(it);
+        }
+    }
+
+    void clear() {
+        booked.clear();
+        unbooked.clear();
+        gaps.clear();
+        freeGaps.clear();
+        rootGap = -1;
+    }
+
+    bool isFree(int slot, long long start, long long end) const {
+        auto it = booked.find(slot);
+        return it != booked.end() ? it->second.isFree(start, end) : isUnbooked(slot);
+    }
+
+    // Book [start, end) on slot; fails if it is not a slot or the window overlaps a booking
+    bool book(int slot, long long start, long long end) {
+        if (start >= end || !isFree(slot, start, end)) return false;
+        auto it = booked.find(slot);
+        if (it == booked.end()) {
+            removeRun(slot, slot);
+            it = booked.emplace(slot, SlotSchedule()).first;
+        } else {
+            long long gapStart, gapEnd;
+            it->second.gapAround(start, end, gapStart, gapEnd);
+            removeGap(gapStart, gapEnd, slot);
+        }
+        long long gapStart, gapEnd;
+        it->second.gapAround(start, end, gapStart, gapEnd);
+        it->second.book(start, end);
+        insertGap(gapStart, start, slot);
+        insertGap(end, gapEnd, slot);
+        return true;
+    }
+
+    // Cancel the booking that is exactly [start, end) on slot
+    bool cancel(int slot, long long start, long long end) {
+        auto it = booked.find(slot);
+        if (it == booked.end() || !it->second.hasBooking(start, end)) return false;
+        long long gapStart, gapEnd;
+        it->second.gapAround(start, end, gapStart, gapEnd);
+        removeGap(gapStart, start, slot);
+        removeGap(end, gapEnd, slot);
+        it->second.cancel(start, end);
+        if (it->second.empty()) {
+            booked.erase(it);
+            addRun(slot, slot);
+        } else {
+            insertGap(gapStart, gapEnd, slot);
+        }
+        return true;
+    }
+
+    // Book the best-fit slot for [start, end); slot receives its key. False
+    // if the window is empty or no slot is free for it.
+    bool bookAny(long long start, long long end, int& slot) {
+        if (start >= end || !bestFit(start, end, slot)) return false;
+        book(slot, start, end);
+        return true;
+    }
+
+    // Earliest start >= from of a session of the given length on any slot;
+    // slot receives the best fit at that time. False if there are no slots.
+    bool earliestStart(long long from, long long duration, long long& start, int& slot) const {
+        start = from;
+        if (bestFit(from, from + duration, slot)) return true;
+        // Nothing fits at from: the earliest start is the first gap opening
+        // later that is long enough, and every slot fitting then opens there
+        int t = leftmostLongEnough(rootGap, from, duration);
+        if (t < 0) return false;
+        start = gaps[t].start;
+        return bestFit(start, start + duration, slot);
+    }
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef SLOT_STATE_LOG_H
+#define SLOT_STATE_LOG_H
+
+#include <condition_variable>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Durable journal of slot state changes. Each change is appended as a
+// length- and checksum-framed record; a background flusher writes whatever
+// has accumulated and issues one fdatasync for the whole batch, so callers
+// that append several changes and then wait once share a single flush
+// (group commit). A checkpoint stores a full snapshot next to the log and
+// truncates the log, keeping replay short. On open, the snapshot and then
+// every intact record are handed back to the owner; a torn tail left by a
+// crash is cut off.
+//
+// A failed write or flush is sticky: nothing appended after it is written
+// (the log must not skip records), and every wait for a record that was not
+// yet durable returns false from then on.
+class SlotStateLog {
+private:
+    static constexpr uint32_t kCheckpointMagic = 0x4b434553;  // "SECK"
+
+    std::string logPath, checkpointPath;
+    int fd = -1;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::string pending;         // Records not yet handed to the flusher
+    uint64_t appendedSeq = 0;    // Records appended so far
+    uint64_t durableSeq = 0;     // Records known to be on disk
+    bool flushing = false;
+    bool stopping = false;
+    bool failed = false;         // A write or flush failed; see the class comment
+    size_t sinceCheckpoint = 0;
+    std::thread flusher;
+
+    // FNV-1a, enough to detect torn or garbled records
+    static uint32_t checksum(const char* data, size_t size) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < size; i++) h = (h ^ (unsigned char)data[i]) * 16777619u;
+        return h;
+    }
+
+    static void appendFrame(std::string& out, const std::string& payload) {
+        uint32_t frame[2] = {(uint32_t)payload.size(), checksum(payload.data(), payload.size())};
+        out.append(reinterpret_cast<const char*>(frame), sizeof(frame));
+        out += payload;
+    }
+
+    static bool readFile(const std::string& path, std::string& contents) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Make a rename in the log's directory durable
+    void syncDirectory() const {
+        size_t slash = checkpointPath.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : checkpointPath.substr(0, slash + 1);
+        int dirFd = ::open(directory.c_str(), O_RDONLY);
+        if (dirFd < 0) return;
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    static bool writeAll(int out, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(out, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            size -= (size_t)written;
+        }
+        return true;
+    }
+
+    // Record a failure (caller holds lock) and wake every waiter
+    void fail() {
+        if (!failed) std::cerr << "Slot state log: write to '" << logPath << "' failed; later changes are not saved.\n";
+        failed = true;
+        pending.clear();
+        changed.notify_all();
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;  // Stopping with nothing left to write
+            std::string batch;
+            batch.swap(pending);
+            uint64_t batchSeq = appendedSeq;
+            flushing = true;
+            guard.unlock();
+            bool ok = writeAll(fd, batch.data(), batch.size()) && fdatasync(fd) == 0;
+            guard.lock();
+            flushing = false;
+            if (ok) {
+                durableSeq = batchSeq;
+                changed.notify_all();
+            } else {
+                fail();
+            }
+        }
+    }
+
+public:
+    SlotStateLog() {}
+
+    ~SlotStateLog() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            changed.notify_all();
+            flusher.join();
+        }
+        if (fd >= 0) ::close(fd);
+    }
+
+    SlotStateLog(const SlotStateLog&) = delete;
+    SlotStateLog& operator=(const SlotStateLog&) = delete;
+
+    // Recover basePath.ckpt and basePath.log, then open the log for appends.
+    // onCheckpoint(snapshot) runs first if a snapshot exists, then
+    // onRecord(payload) for each intact record in order. Returns false if the
+    // log cannot be opened.
+    template <typename OnCheckpoint, typename OnRecord>
+    bool open(const std::string& basePath, OnCheckpoint onCheckpoint, OnRecord onRecord) {
+        logPath = basePath + ".log";
+        checkpointPath = basePath + ".ckpt";
+
+        std::string contents;
+        if (readFile(checkpointPath, contents) && contents.size() >= 12) {
+            uint32_t header[3];
+            memcpy(header, contents.data(), sizeof(header));
+            if (header[0] == kCheckpointMagic && header[1] == contents.size() - 12 &&
+                header[2] == checksum(contents.data() + 12, header[1])) {
+                onCheckpoint(contents.substr(12));
+            }
+        }
+
+        size_t intact = 0;
+        if (readFile(logPath, contents)) {
+            while (contents.size() - intact >= 8) {
+                uint32_t frame[2];
+                memcpy(frame, contents.data() + intact, sizeof(frame));
+                if (frame[0] > contents.size() - intact - 8 ||
+                    frame[1] != checksum(contents.data() + intact + 8, frame[0])) {
+                    break;  // Torn or corrupt tail
+                }
+                onRecord(contents.substr(intact + 8, frame[0]));
+                intact += 8 + frame[0];
+                sinceCheckpoint++;
+            }
+        }
+
+        fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0 || ftruncate(fd, (off_t)intact) != 0) return false;
+        flusher = std::thread(&SlotStateLog::flushLoop, this);
+        return true;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Queue a record without waiting; returns its sequence number for waitDurable
+    uint64_t append(const std::string& payload) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!failed) {
+            appendFrame(pending, payload);
+            changed.notify_all();
+        }
+        sinceCheckpoint++;
+        return ++appendedSeq;
+    }
+
+    // Block until record seq (and everything before it) is on disk. Returns
+    // false if the log failed first, in which case the record is lost.
+    bool waitDurable(uint64_t seq) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return durableSeq >= seq || failed; });
+        return durableSeq >= seq;
+    }
+
+    // Append a record and wait until it is durable; false if it was not saved
+    bool commit(const std::string& payload) { return waitDurable(append(payload)); }
+
+    size_t recordsSinceCheckpoint() {
+        std::lock_guard<std::mutex> guard(lock);
+        return sinceCheckpoint;
+    }
+
+    // Replace the log with a snapshot that already reflects every appended
+    // record. The snapshot is written and renamed into place before the log
+    // is truncated, so a crash at any point leaves a recoverable state.
+    // Refused once the log has failed.
+    bool checkpoint(const std::string& snapshot) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return (pending.empty() && !flushing) || failed; });
+        if (failed) return false;
+
+        std::string temporary = checkpointPath + ".tmp";
+        int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) return false;
+        uint32_t header[3] = {kCheckpointMagic, (uint32_t)snapshot.size(), checksum(snapshot.data(), snapshot.size())};
+        bool ok = writeAll(out, reinterpret_cast<const char*>(header), sizeof(header)) &&
+                  writeAll(out, snapshot.data(), snapshot.size()) && fsync(out) == 0;
+        ::close(out);
+        if (!ok || rename(temporary.c_str(), checkpointPath.c_str()) != 0) return false;
+        syncDirectory();
+        if (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0) {
+            fail();
+            return false;
+        }
+        sinceCheckpoint = 0;
+        return true;
+    }
+};
+
+#endif
@@ -1,81 +1,43 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
-using namespace std;
-
-// Sparse Table for range maximum queries
-class SparseTable {
-private:
-    vector<vector<int>> table;
-    vector<int> log;
-
-public:
-    // Build the Sparse Table
-    SparseTable(const vector<int>& data) {
-        int n = data.size();
-        log.resize(n + 1);
-        log[1] = 0;
-        for (int i = 2; i <= n; i++) {
-            log[i] = log[i / 2] + 1;
-        }
-
-        int k = log[n];
-        table.resize(n, vector<int>(k + 1));
-
-        // Initialize Sparse Table with input data
-        for (int i = 0; i < n; i++) {
-            table[i][0] = data[i];
-        }
-
-        // Build the Sparse Table
-        for (int j = 1; j <= k; j++) {
-            for (int i = 0; i + (1 << j) <= n; i++) {
-                table[i][j] = max(table[i][j - 1], table[i + (1 << (j - 1))][j - 1]);
-            }
-        }
-    }
+#include <algorithm>
+#include <thread>
+#include <cstdint>
+#include <array>
+#include <utility>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <stdexcept>
 
-    // Query for the maximum in a range [L, R]
-    int query(int L, int R) {
-        int j = log[R - L + 1];
-        return max(table[L][j], table[R - (1 << j) + 1][j]);
-    }
+#include "sparse_table.h"
+#include "trace_harness.h"
 
-    // Update traffic data for a segment
-    void updateTrafficData(vector<int>& data, int segmentID, int trafficCount) {
-        data[segmentID] = trafficCount;
-        // Rebuild the Sparse Table after data update
-        *this = SparseTable(data);
-    }
+using namespace std;
 
-    // Display all traffic data
-    void displayTrafficData(const vector<int>& data) {
-        cout << "Traffic Data for All Segments:\n";
-        for (size_t i = 0; i < data.size(); i++) {
-            cout << "Segment " << (i + 1) << ": " << data[i] << " vehicles\n";  // 1-based index
-        }
+// Print every segment's count (1-based, as in the menu)
+void displayTrafficData(const vector<int>& data) {
+    cout << "Traffic Data for All Segments:\n";
+    for (size_t i = 0; i < data.size(); i++) {
+        cout << "Segment " << (i + 1) << ": " << data[i] << " vehicles\n";
     }
-};
-
-int main() {
-    int n;
-
-    // Ask user for the number of traffic segments
-    cout << "Enter the number of traffic segments: ";
-    cin >> n;
-
-    vector<int> trafficData(n);
-
-    // Build Sparse Table
-    SparseTable sparseTable(trafficData);
+}
 
+// Run the interactive menu against either range maximum structure
+template <typename RangeMaxTable>
+void runTrafficMenu(RangeMaxTable& sparseTable, vector<int>& trafficData) {
+    int n = trafficData.size();
     int choice;
     do {
         cout << "\nMenu:\n";
         cout << "1. Update Traffic Data\n";
         cout << "2. Query Maximum Traffic in Range\n";
         cout << "3. Display All Traffic Data\n";
-        cout << "4. Exit\n";
+        cout << "4. Query Maximum Traffic for Multiple Ranges\n";
+        cout << "5. Exit\n";
         cout << "Enter your choice: ";
         cin >> choice;
 
@@ -90,7 +52,8 @@ int main() {
                 }
                 cout << "Enter the new traffic count for segment " << segmentID << ": ";
                 cin >> trafficCount;
-                sparseTable.updateTrafficData(trafficData, segmentID - 1, trafficCount);  // Convert to 0-based
+                trafficData[segmentID - 1] = trafficCount;
+                sparseTable.update(segmentID - 1, trafficCount);  // Convert to 0-based
                 cout << "Traffic data updated for segment " << segmentID << ".\n";
                 break;
             }
@@ -107,15 +70,206 @@ int main() {
                 break;
             }
             case 3:
-                sparseTable.displayTrafficData(trafficData);
+                displayTrafficData(trafficData);
                 break;
-            case 4:
+            case 4: {
+                int count;
+                cout << "Enter the number of ranges: ";
+                cin >> count;
+                vector<pair<int, int>> ranges;
+                cout << "Enter each range as L R (1-based index):\n";
+                for (int i = 0; i < count; i++) {
+                    int L, R;
+                    cin >> L >> R;
+                    if (L < 1 || R > n || L > R) {
+                        cout << "Skipping invalid range " << L << " " << R << ". Please ensure 1 <= L <= R <= " << n << ".\n";
+                        continue;
+                    }
+                    ranges.emplace_back(L - 1, R - 1);  // Convert to 0-based
+                }
+                vector<int> results;
+                sparseTable.queryBatch(ranges, results);
+                for (size_t i = 0; i < ranges.size(); i++) {
+                    cout << "Maximum traffic between segment " << ranges[i].first + 1 << " and "
+                         << ranges[i].second + 1 << ": " << results[i] << " vehicles\n";
+                }
+                break;
+            }
+            case 5:
                 cout << "Exiting program...\n";
                 break;
             default:
                 cout << "Invalid choice! Please try again.\n";
         }
-    } while (choice != 4);  // Repeat until the user chooses to exit
+    } while (choice != 5);  // Repeat until the user chooses to exit
+}
+
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its whitespace-separated arguments ('#' starts a comment line);
+// segments are 1-based as in the menu. --generate writes a random trace;
+// --replay runs a trace through a naive reference (a plain array scanned per
+// query) and through both Sparse Table variants, times each and reports the
+// first answer that differs.
+//
+//   N n                    number of segments, all starting at 0 (first line)
+//   U segment count        update a segment
+//   Q L R                  maximum over [L, R]
+//   B L1 R1 L2 R2 ...      batch of maximum queries
+
+// The 0-based ranges of a Q or B op, checked against n segments
+vector<pair<int, int>> traceRanges(const TraceOp& op, int n) {
+    if (op.args.empty() || op.args.size() % 2) throw invalid_argument("range ops take L R pairs");
+    vector<pair<int, int>> ranges;
+    for (size_t i = 0; i < op.args.size(); i += 2) {
+        int L = stoi(op.args[i]), R = stoi(op.args[i + 1]);
+        if (L < 1 || R > n || L > R) throw out_of_range("range " + op.args[i] + " " + op.args[i + 1]);
+        ranges.emplace_back(L - 1, R - 1);
+    }
+    return ranges;
+}
+
+// Answer one trace op with a range maximum structure over data; with a null
+// table every query scans data directly (the reference)
+template <typename RangeMaxTable>
+string applyToTable(RangeMaxTable* table, vector<int>& data, const TraceOp& op) {
+    int n = data.size();
+    if (op.op == 'U') {
+        int segmentID = stoi(op.args.at(0)), trafficCount = stoi(op.args.at(1));
+        if (segmentID < 1 || segmentID > n) throw out_of_range("segment " + op.args[0]);
+        data[segmentID - 1] = trafficCount;
+        if (table) table->update(segmentID - 1, trafficCount);
+        return "";
+    }
+    if (op.op != 'Q' && op.op != 'B') return "";
+
+    vector<pair<int, int>> ranges = traceRanges(op, n);
+    vector<int> results;
+    if (!table) {
+        for (const auto& range : ranges) {
+            results.push_back(*max_element(data.begin() + range.first, data.begin() + range.second + 1));
+        }
+    } else if (op.op == 'Q') {
+        results.push_back(table->query(ranges[0].first, ranges[0].second));
+    } else {
+        table->queryBatch(ranges, results);
+    }
+    string answer;
+    for (int result : results) answer += (answer.empty() ? "" : " ") + to_string(result);
+    return answer;
+}
+
+// Write a random trace over the given number of segments. Ranges are a mix
+// of short windows and arbitrary spans.
+bool generateTrafficTrace(const string& path, long long operations, int segments, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    auto range = [&]() {
+        int L = 1 + rng() % segments;
+        int span = rng() % 2 ? 64 : segments;
+        int R = L + (int)(rng() % min(span, segments - L + 1));
+        return to_string(L) + " " + to_string(R);
+    };
+
+    out << "# Sparse Table trace, seed " << seed << "\n";
+    out << "N " << segments << "\n";
+    for (long long i = 0; i < operations; i++) {
+        unsigned kind = rng() % 20;
+        if (kind == 0) {
+            out << "U " << 1 + rng() % segments << " " << rng() % 1000 << "\n";
+        } else if (kind < 4) {
+            out << "B";
+            for (int r = 0; r < 16; r++) out << " " << range();
+            out << "\n";
+        } else {
+            out << "Q " << range() << "\n";
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and both Sparse Table variants;
+// returns the exit code
+int replayTrafficTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    if (trace.empty() || trace[0].op != 'N' || trace[0].args.empty() || atoi(trace[0].args[0].c_str()) < 1) {
+        cerr << "Trace must start with N <segments>.\n";
+        return 1;
+    }
+    int n = atoi(trace[0].args[0].c_str());
+    try {
+        vector<string> expected, answers;
+        vector<int> referenceData(n);
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) {
+            return applyToTable<SparseTable<int, MaxOp>>(nullptr, referenceData, op);
+        });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        bool matched = true;
+        {
+            vector<int> data(n);
+            SparseTable<int, MaxOp> table(data);
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToTable(&table, data, op); });
+            matched = reportRun("SparseTable", trace, seconds, answers, &expected) && matched;
+        }
+        {
+            vector<int> data(n);
+            BlockSparseTable<int> table(data);
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToTable(&table, data, op); });
+            matched = reportRun("BlockSparseTable", trace, seconds, answers, &expected) && matched;
+        }
+        return matched ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> <segments> [seed]
+    //   --replay <trace>
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        int segments = atoi(argv[4]);
+        if (segments < 1) {
+            cerr << "Segment count must be positive.\n";
+            return 1;
+        }
+        if (!generateTrafficTrace(argv[2], atoll(argv[3]), segments, argc >= 6 ? (unsigned)atoi(argv[5]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayTrafficTrace(argv[2]);
+    }
+
+    int n;
+
+    // Ask user for the number of traffic segments
+    cout << "Enter the number of traffic segments: ";
+    cin >> n;
+
+    vector<int> trafficData(n);
+
+    // Linear-space mode trades a little query work for far less memory on large inputs
+    char mode;
+    cout << "Use linear-space (block) Sparse Table? (y/n): ";
+    cin >> mode;
+
+    // Build Sparse Table
+    if (mode == 'y' || mode == 'Y') {
+        BlockSparseTable<int> sparseTable(trafficData);
+        runTrafficMenu(sparseTable, trafficData);
+    } else {
+        SparseTable<int, MaxOp> sparseTable(trafficData);
+        runTrafficMenu(sparseTable, trafficData);
+    }
 
     return 0;
 }
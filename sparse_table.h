@@ -0,0 +1,585 @@
+#ifndef SPARSE_TABLE_H
+#define SPARSE_TABLE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Default number of threads used to build sparse table levels
+inline unsigned defaultBuildThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run body(begin, end) over [0, n), split into contiguous chunks across up to
+// numThreads threads. Small ranges run inline since thread start-up would dominate.
+template <typename Body>
+void parallelFor(size_t n, unsigned numThreads, Body body) {
+    const size_t kMinChunk = size_t(1) << 16;
+    size_t numChunks = std::min<size_t>(std::max(1u, numThreads), (n + kMinChunk - 1) / kMinChunk);
+    if (numChunks <= 1) {
+        body(size_t(0), n);
+        return;
+    }
+
+    size_t chunk = (n + numChunks - 1) / numChunks;
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < numChunks; c++) {
+        workers.emplace_back(body, c * chunk, std::min(n, (c + 1) * chunk));
+    }
+    body(size_t(0), chunk);
+    for (std::thread& worker : workers) worker.join();
+}
+
+// Index of the lowest / highest set bit of a non-zero mask
+constexpr int lowestSetBit(uint32_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1u)) { mask >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+constexpr int highestSetBit(uint32_t mask) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(mask);
+#else
+    int bit = 0;
+    while (mask >>= 1) bit++;
+    return bit;
+#endif
+}
+
+constexpr int highestSetBit64(uint64_t mask) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(mask);
+#else
+    int bit = 0;
+    while (mask >>= 1) bit++;
+    return bit;
+#endif
+}
+
+// Ask the CPU to start loading addr into cache ahead of use
+inline void prefetchRead(const void* addr) {
+#if defined(__GNUC__)
+    __builtin_prefetch(addr, 0, 1);
+#else
+    (void)addr;
+#endif
+}
+
+// floor(log2(n)) for n >= 1: the highest Sparse Table level whose window fits n
+constexpr int floorLog2(uint32_t n) {
+    return highestSetBit(n);
+}
+
+// Growable array whose elements never move. Chunk k holds 2^(6 + k)
+// elements and is allocated only when the array first reaches it, so
+// growing to n elements allocates O(log n) chunks and copies nothing. The
+// size is published with a release store after the new elements are
+// written: a reader that loads size() may read every element below it
+// while another thread grows the array. Changing an existing element, and
+// clear(), still need the writer to exclude readers.
+template <typename T>
+class ChunkedArray {
+private:
+    static const int kFirstChunkBits = 6;
+    static const int kMaxChunks = 33 - kFirstChunkBits;   // Enough for 2^32 elements
+    static const size_t kFirstChunk = size_t(1) << kFirstChunkBits;
+
+    std::array<std::unique_ptr<T[]>, kMaxChunks> chunks;
+    // Address of chunk k minus chunkStart(k) elements, so element i of
+    // chunk k is at bases[k] + i * sizeof(T) and a lookup is one bit scan
+    // and one load ahead of the element itself
+    std::array<uintptr_t, kMaxChunks> bases{};
+    int numChunks = 0;
+    std::atomic<size_t> count{0};
+
+    // Chunk k starts at element kFirstChunk * (2^k - 1)
+    static size_t chunkStart(int k) { return (kFirstChunk << k) - kFirstChunk; }
+
+    static int chunkOf(size_t i) { return highestSetBit64(i + kFirstChunk) - kFirstChunkBits; }
+
+    void reserve(size_t n) {
+        while (chunkStart(numChunks) < n) {
+            chunks[numChunks].reset(new T[kFirstChunk << numChunks]);
+            bases[numChunks] = reinterpret_cast<uintptr_t>(chunks[numChunks].get()) - chunkStart(numChunks) * sizeof(T);
+            numChunks++;
+        }
+    }
+
+public:
+    ChunkedArray() = default;
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    // Elements from i to the end of i's chunk, which are contiguous in memory
+    size_t contiguousFrom(size_t i) const {
+        int k = chunkOf(i);
+        return (kFirstChunk << k) - (i - chunkStart(k));
+    }
+
+    const T& operator[](size_t i) const {
+        return *reinterpret_cast<const T*>(bases[chunkOf(i)] + i * sizeof(T));
+    }
+
+    T& operator[](size_t i) {
+        return *reinterpret_cast<T*>(bases[chunkOf(i)] + i * sizeof(T));
+    }
+
+    // Grow to n elements set to value, or drop the elements from n on
+    // (their chunks are kept for regrowth)
+    void resize(size_t n, const T& value = T()) {
+        size_t old = count.load(std::memory_order_relaxed);
+        reserve(n);
+        for (size_t i = old; i < n; i++) (*this)[i] = value;
+        count.store(n, std::memory_order_release);
+    }
+
+    template <typename Iterator>
+    void append(Iterator first, Iterator last) {
+        size_t n = count.load(std::memory_order_relaxed);
+        reserve(n + std::distance(first, last));
+        for (; first != last; ++first) (*this)[n++] = *first;
+        count.store(n, std::memory_order_release);
+    }
+
+    // Call visit(data, length) for each contiguous run of [begin, end)
+    template <typename Visit>
+    void forEachSpan(size_t begin, size_t end, Visit visit) const {
+        while (begin < end) {
+            int k = chunkOf(begin);
+            size_t offset = begin - chunkStart(k);
+            size_t length = std::min(end - begin, (kFirstChunk << k) - offset);
+            visit(chunks[k].get() + offset, length);
+            begin += length;
+        }
+    }
+
+    std::vector<T> copy(size_t begin, size_t end) const {
+        std::vector<T> out;
+        out.reserve(end - begin);
+        forEachSpan(begin, end, [&out](const T* data, size_t length) { out.insert(out.end(), data, data + length); });
+        return out;
+    }
+
+    // Release every chunk
+    void clear() {
+        count.store(0, std::memory_order_release);
+        for (int k = 0; k < numChunks; k++) chunks[k].reset();
+        numChunks = 0;
+    }
+};
+
+// Idempotent combine operations for SparseTable
+struct MaxOp {
+    template <typename T>
+    T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+struct MinOp {
+    template <typename T>
+    T operator()(T a, T b) const { return b < a ? b : a; }
+};
+
+struct GcdOp {
+    template <typename T>
+    T operator()(T a, T b) const { return std::gcd(a, b); }
+};
+
+struct BitAndOp {
+    template <typename T>
+    T operator()(T a, T b) const { return a & b; }
+};
+
+struct BitOrOp {
+    template <typename T>
+    T operator()(T a, T b) const { return a | b; }
+};
+
+// Sparse Table answering range queries for one or more idempotent operations
+// (op(x, x) == x, so two overlapping power-of-two windows cover any range).
+// With several operations the per-position results are stored interleaved:
+// SparseTable<int, MaxOp, MinOp> keeps {max, min} side by side, so one query
+// reads two cells and gets every result from the same cache lines.
+//
+// Levels live in ChunkedArrays, so append never moves a built cell, and the
+// size is published only once every level covers the new positions: a
+// reader may query any range below size() while another thread appends.
+// build, update and clear still need the writer to exclude readers.
+template <typename T, typename... Ops>
+class SparseTable {
+public:
+    static constexpr size_t kNumOps = sizeof...(Ops);
+    typedef std::array<T, kNumOps> Cell;
+
+private:
+    static const int kMaxLevels = 32;          // floorLog2 of a 32-bit size is at most 31
+
+    std::array<ChunkedArray<Cell>, kMaxLevels> levels;   // levels[j][i] combines positions i .. i + 2^j - 1
+    int numLevels = 0;
+    std::atomic<size_t> published{0};          // Positions every level covers
+    unsigned buildThreads;
+
+    // Call store(levels[j][i], combined) for i in [begin, end), where
+    // combined joins the two windows of level j - 1 it covers. Works a
+    // contiguous run at a time so the inner loop is plain pointer arithmetic.
+    template <typename Store>
+    void combineLevel(int j, size_t begin, size_t end, Store store) {
+        const ChunkedArray<Cell>& prev = levels[j - 1];
+        ChunkedArray<Cell>& level = levels[j];
+        size_t half = size_t(1) << (j - 1);
+        while (begin < end) {
+            size_t length = std::min({end - begin, level.contiguousFrom(begin), prev.contiguousFrom(begin + half)});
+            const Cell* low = &prev[begin];
+            const Cell* high = &prev[begin + half];
+            Cell* out = &level[begin];
+            for (size_t k = 0; k < length; k++) store(out[k], combine(low[k], high[k]));
+            begin += length;
+        }
+    }
+
+    // Fill levels[j] from `first` up to its size for n positions, from the
+    // level below
+    void buildLevel(int j, size_t n, size_t first) {
+        levels[j].resize(n - (size_t(1) << j) + 1);
+        parallelFor(levels[j].size() - first, buildThreads, [this, j, first](size_t begin, size_t end) {
+            combineLevel(j, first + begin, first + end, [](Cell& out, const Cell& combined) { out = combined; });
+        });
+    }
+
+    template <size_t... I>
+    static Cell combine(const Cell& a, const Cell& b, std::index_sequence<I...>) {
+        return Cell{{Ops()(a[I], b[I])...}};
+    }
+
+    static Cell combine(const Cell& a, const Cell& b) {
+        return combine(a, b, std::index_sequence_for<Ops...>());
+    }
+
+    static Cell cellOf(T value) {
+        Cell cell;
+        cell.fill(value);
+        return cell;
+    }
+
+public:
+    SparseTable(unsigned numThreads = defaultBuildThreads()) : buildThreads(numThreads) {}
+
+    explicit SparseTable(const std::vector<T>& data, unsigned numThreads = defaultBuildThreads())
+        : buildThreads(numThreads) {
+        build(data);
+    }
+
+    void setBuildThreads(unsigned numThreads) {
+        buildThreads = std::max(1u, numThreads);
+    }
+
+    size_t size() const { return published.load(std::memory_order_acquire); }
+
+    // Build from one value per position; every operation starts from the same data
+    void build(const std::vector<T>& data) {
+        std::vector<Cell> base(data.size());
+        for (size_t i = 0; i < data.size(); i++) base[i] = cellOf(data[i]);
+        build(std::move(base));
+    }
+
+    // Build from prepared per-position cells. Every cell of a level depends only
+    // on the level below, so each level is split across buildThreads threads.
+    void build(const std::vector<Cell>& base) {
+        size_t n = base.size();
+        for (int j = 0; j < numLevels; j++) levels[j].resize(0);
+        numLevels = n > 0 ? floorLog2(n) + 1 : 0;
+        levels[0].append(base.begin(), base.end());
+        for (int j = 1; j < numLevels; j++) buildLevel(j, n, 0);
+        published.store(n, std::memory_order_release);
+    }
+
+    // Append positions after the existing ones. Cells already built are left
+    // untouched: each level only gains the windows that reach into the new
+    // positions, and levels whose window now fits are added on top. The new
+    // size is published last, so concurrent readers never see a partly
+    // built level.
+    void append(const std::vector<T>& data) {
+        std::vector<Cell> cells(data.size());
+        for (size_t i = 0; i < data.size(); i++) cells[i] = cellOf(data[i]);
+        append(cells);
+    }
+
+    void append(const std::vector<Cell>& cells) {
+        if (cells.empty()) return;
+        levels[0].append(cells.begin(), cells.end());
+        size_t n = levels[0].size();
+        int oldLevels = numLevels;
+        numLevels = floorLog2(n) + 1;
+        for (int j = 1; j < numLevels; j++) buildLevel(j, n, j < oldLevels ? levels[j].size() : 0);
+        published.store(n, std::memory_order_release);
+    }
+
+    // Replace one position and recompute the windows covering it, level by
+    // level. A level whose windows all come out unchanged leaves every level
+    // above it unchanged too, so most updates stop after a few levels. An
+    // update that sets a new extreme of a long run does not stop early and
+    // touches about 2n cells, as much as building the upper levels. Returns
+    // the number of cells recomputed, so callers can tell when a batch of
+    // updates has cost more than a rebuild would.
+    size_t update(size_t pos, T value) {
+        return update(pos, cellOf(value));
+    }
+
+    size_t update(size_t pos, const Cell& cell) {
+        if (levels[0][pos] == cell) return 0;
+        levels[0][pos] = cell;
+        size_t touched = 1;
+        for (int j = 1; j < numLevels; j++) {
+            size_t window = size_t(1) << j;
+            size_t first = pos + 1 >= window ? pos + 1 - window : 0;
+            size_t last = std::min(pos, levels[j].size() - 1);
+            bool changed = false;
+            combineLevel(j, first, last + 1, [&changed](Cell& out, const Cell& combined) {
+                if (combined != out) {
+                    out = combined;
+                    changed = true;
+                }
+            });
+            touched += last + 1 - first;
+            if (!changed) break;
+        }
+        return touched;
+    }
+
+    // Cells a build over n positions computes, in the units update returns
+    static size_t buildCells(size_t n) {
+        return n > 0 ? n * (floorLog2(n) + 1) : 0;
+    }
+
+    // Every operation's result over 0-based [L, R]
+    Cell queryAll(int L, int R) const {
+        int j = floorLog2(R - L + 1);
+        return combine(levels[j][L], levels[j][R - (1 << j) + 1]);
+    }
+
+    // Result of the op-th operation over 0-based [L, R]
+    T query(int L, int R, size_t op = 0) const {
+        return queryAll(L, R)[op];
+    }
+
+    // Start loading the two cells a query over [L, R] will read
+    void prefetch(int L, int R) const {
+        int j = floorLog2(R - L + 1);
+        prefetchRead(&levels[j][L]);
+        prefetchRead(&levels[j][R - (1 << j) + 1]);
+    }
+
+    // Answer many 0-based [L, R] ranges for the op-th operation. The cells of
+    // the range kPrefetchDistance ahead are prefetched while the current one is
+    // combined, so the cache misses of independent queries overlap.
+    template <typename Result>
+    void queryBatch(const std::vector<std::pair<int, int>>& ranges, std::vector<Result>& results, size_t op = 0) const {
+        const size_t kPrefetchDistance = 8;
+        results.resize(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (i + kPrefetchDistance < ranges.size()) {
+                prefetch(ranges[i + kPrefetchDistance].first, ranges[i + kPrefetchDistance].second);
+            }
+            results[i] = query(ranges[i].first, ranges[i].second, op);
+        }
+    }
+
+    void clear() {
+        published.store(0, std::memory_order_release);
+        for (int j = 0; j < numLevels; j++) levels[j].clear();
+        numLevels = 0;
+    }
+};
+
+// Range max and min over the same counts, stored interleaved
+template <typename Count>
+using MaxMinSparseTable = SparseTable<Count, MaxOp, MinOp>;
+const size_t kMaxLane = 0, kMinLane = 1;
+
+// Linear-space range max/min structure (block decomposition). Data is cut
+// into blocks of 32 and a SparseTable covers only the per-block max and min.
+// Inside a block every position keeps 32-bit masks of the running suffix
+// maxima and minima, so a partial block is answered with a mask and a bit
+// scan. Queries stay O(1) while memory drops from n log n to about 3 ints per segment.
+//
+// A query only reads the block table for blocks strictly between its end
+// blocks, never the last one, so the table covers complete blocks only and
+// growth just appends to it. As in SparseTable, storage never moves and the
+// size is published last, so readers may query below size() during append.
+template <typename Count>
+class BlockSparseTable {
+private:
+    typedef typename MaxMinSparseTable<Count>::Cell Cell;
+    static const int kBlockSize = 32;
+
+    ChunkedArray<Count> values;
+    ChunkedArray<uint32_t> suffixMaxMask, suffixMinMask;
+    MaxMinSparseTable<Count> blockTable;   // {max, min} of each complete block
+    std::atomic<size_t> published{0};
+    unsigned buildThreads;
+
+    // Compute the in-block masks of block b from position `from` on (the
+    // masks before it are kept: each depends only on the positions up to
+    // it) and return the {max, min} of the block so far
+    Cell buildBlock(size_t b, size_t from) {
+        size_t base = b * kBlockSize;
+        size_t end = std::min(values.size(), base + kBlockSize);
+        uint32_t maxStack = from > base ? suffixMaxMask[from - 1] : 0;
+        uint32_t minStack = from > base ? suffixMinMask[from - 1] : 0;
+        for (size_t i = from; i < end; i++) {
+            while (maxStack && values[base + highestSetBit(maxStack)] <= values[i]) {
+                maxStack &= ~(1u << highestSetBit(maxStack));
+            }
+            while (minStack && values[base + highestSetBit(minStack)] >= values[i]) {
+                minStack &= ~(1u << highestSetBit(minStack));
+            }
+            maxStack |= 1u << (i - base);
+            minStack |= 1u << (i - base);
+            suffixMaxMask[i] = maxStack;
+            suffixMinMask[i] = minStack;
+        }
+        Cell cell;
+        cell[kMaxLane] = values[base + lowestSetBit(maxStack)];
+        cell[kMinLane] = values[base + lowestSetBit(minStack)];
+        return cell;
+    }
+
+    // Rebuild the masks of the blocks holding positions [from, values.size())
+    // and return the cells of those that are complete
+    std::vector<Cell> buildBlocksFrom(size_t from) {
+        size_t n = values.size();
+        size_t firstBlock = from / kBlockSize, completeBlocks = n / kBlockSize;
+        size_t numBlocks = (n + kBlockSize - 1) / kBlockSize - firstBlock;
+        suffixMaxMask.resize(n);
+        suffixMinMask.resize(n);
+        std::vector<Cell> cells(numBlocks);
+        parallelFor(numBlocks, buildThreads, [this, &cells, from, firstBlock](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                size_t b = firstBlock + k;
+                cells[k] = buildBlock(b, std::max(from, b * kBlockSize));
+            }
+        });
+        cells.resize(completeBlocks > firstBlock ? completeBlocks - firstBlock : 0);
+        return cells;
+    }
+
+    // Position of the max (or min) of 0-based [L, R] when both lie in one block
+    int inBlockArg(const ChunkedArray<uint32_t>& masks, int L, int R) const {
+        int base = R - R % kBlockSize;
+        return base + lowestSetBit(masks[R] & (~0u << (L - base)));
+    }
+
+public:
+    BlockSparseTable(unsigned numThreads = defaultBuildThreads())
+        : blockTable(numThreads), buildThreads(numThreads) {}
+
+    explicit BlockSparseTable(const std::vector<Count>& data, unsigned numThreads = defaultBuildThreads())
+        : blockTable(numThreads), buildThreads(numThreads) {
+        build(data);
+    }
+
+    void setBuildThreads(unsigned numThreads) {
+        buildThreads = std::max(1u, numThreads);
+        blockTable.setBuildThreads(buildThreads);
+    }
+
+    size_t size() const { return published.load(std::memory_order_acquire); }
+
+    void build(const std::vector<Count>& arr) {
+        values.resize(0);
+        values.append(arr.begin(), arr.end());
+        blockTable.build(buildBlocksFrom(0));
+        published.store(arr.size(), std::memory_order_release);
+    }
+
+    // Append positions after the existing ones. The last, partly filled
+    // block is continued from its first new position, and only blocks this
+    // completes are appended to the block table.
+    void append(const std::vector<Count>& added) {
+        if (added.empty()) return;
+        size_t from = values.size();
+        values.append(added.begin(), added.end());
+        blockTable.append(buildBlocksFrom(from));
+        published.store(values.size(), std::memory_order_release);
+    }
+
+    // Replace one position: its block's masks are rebuilt, and the block
+    // table is touched only if the block is complete and its max or min
+    // changed. Returns the number of cells recomputed (see SparseTable::update).
+    size_t update(size_t pos, Count value) {
+        if (values[pos] == value) return 0;
+        values[pos] = value;
+        size_t block = pos / kBlockSize;
+        Cell cell = buildBlock(block, block * kBlockSize);
+        size_t touched = kBlockSize;
+        if (block < blockTable.size()) touched += blockTable.update(block, cell);
+        return touched;
+    }
+
+    // Cells a build over n positions computes, in the units update returns
+    static size_t buildCells(size_t n) {
+        return n + MaxMinSparseTable<Count>::buildCells(n / kBlockSize);
+    }
+
+    void clear() {
+        published.store(0, std::memory_order_release);
+        values.clear();
+        suffixMaxMask.clear();
+        suffixMinMask.clear();
+        blockTable.clear();
+    }
+
+    // Max (lane kMaxLane) or min (lane kMinLane) over 0-based [L, R]
+    int query(int L, int R, size_t lane = kMaxLane) const {
+        const ChunkedArray<uint32_t>& masks = lane == kMaxLane ? suffixMaxMask : suffixMinMask;
+        int firstBlock = L / kBlockSize, lastBlock = R / kBlockSize;
+        if (firstBlock == lastBlock) return values[inBlockArg(masks, L, R)];
+
+        int left = values[inBlockArg(masks, L, firstBlock * kBlockSize + kBlockSize - 1)];
+        int right = values[inBlockArg(masks, lastBlock * kBlockSize, R)];
+        int best = lane == kMaxLane ? std::max(left, right) : std::min(left, right);
+        if (firstBlock + 1 < lastBlock) {
+            int middle = blockTable.query(firstBlock + 1, lastBlock - 1, lane);
+            best = lane == kMaxLane ? std::max(best, middle) : std::min(best, middle);
+        }
+        return best;
+    }
+
+    // Start loading the masks, values and block cells a query over [L, R] will read
+    void prefetch(int L, int R, size_t lane = kMaxLane) const {
+        const ChunkedArray<uint32_t>& masks = lane == kMaxLane ? suffixMaxMask : suffixMinMask;
+        prefetchRead(&masks[std::min(R, L - L % kBlockSize + kBlockSize - 1)]);
+        prefetchRead(&masks[R]);
+        prefetchRead(&values[L]);
+        prefetchRead(&values[R]);
+        if (L / kBlockSize + 1 < R / kBlockSize) blockTable.prefetch(L / kBlockSize + 1, R / kBlockSize - 1);
+    }
+
+    // Answer many 0-based ranges, prefetching kPrefetchDistance queries ahead
+    void queryBatch(const std::vector<std::pair<int, int>>& ranges, std::vector<int>& results, size_t lane = kMaxLane) const {
+        const size_t kPrefetchDistance = 8;
+        results.resize(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (i + kPrefetchDistance < ranges.size()) {
+                prefetch(ranges[i + kPrefetchDistance].first, ranges[i + kPrefetchDistance].second, lane);
+            }
+            results[i] = query(ranges[i].first, ranges[i].second, lane);
+        }
+    }
+};
+
+#endif
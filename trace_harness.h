@@ -0,0 +1,94 @@
+#ifndef TRACE_HARNESS_H
+#define TRACE_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Trace-replay helpers shared by the programs' --generate / --replay modes.
+// A trace is a text file with one op per line: a one-letter op code and its
+// whitespace-separated arguments; blank lines and '#' comments are skipped.
+// Each program supplies a naive reference and an apply function that turns
+// an op into its answer string, and replay compares the two op by op.
+
+struct TraceOp {
+    char op;
+    std::vector<std::string> args;
+};
+
+inline bool readTrace(const std::string& path, std::vector<TraceOp>& trace) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string op;
+        if (!(fields >> op) || op[0] == '#') continue;
+        TraceOp entry{op[0], {}};
+        for (std::string arg; fields >> arg;) entry.args.push_back(arg);
+        trace.push_back(std::move(entry));
+    }
+    return true;
+}
+
+inline std::string formatOp(const TraceOp& op) {
+    std::string text(1, op.op);
+    for (const std::string& arg : op.args) text += " " + arg;
+    return text;
+}
+
+// Run apply over every op of the trace; answers[i] is op i's result (empty
+// for updates). Returns the elapsed seconds.
+template <typename Apply>
+double runTrace(const std::vector<TraceOp>& trace, std::vector<std::string>& answers, Apply apply) {
+    answers.assign(trace.size(), "");
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.size(); i++) answers[i] = apply(trace[i]);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Print a run's timing and, when expected is given, its first answer that
+// differs from it. Every op is compared, an empty answer included, except
+// those whose letter is in unsupportedOps: a run that answers only some
+// kinds of query names the rest there. Returns false on a mismatch.
+inline bool reportRun(const std::string& name, const std::vector<TraceOp>& trace, double seconds,
+                      const std::vector<std::string>& answers, const std::vector<std::string>* expected,
+                      const std::string& unsupportedOps = "") {
+    std::cout << name << ": " << trace.size() << " ops in " << seconds * 1000 << " ms ("
+              << (long long)(trace.size() / std::max(seconds, 1e-9)) << " ops/sec)";
+    if (expected) {
+        for (size_t i = 0; i < answers.size(); i++) {
+            if (answers[i] == (*expected)[i] || unsupportedOps.find(trace[i].op) != std::string::npos) continue;
+            std::cout << "\n  MISMATCH at op " << i + 1 << " (" << formatOp(trace[i]) << "): expected "
+                      << (*expected)[i] << ", got " << answers[i] << "\n";
+            return false;
+        }
+        std::cout << ", matches reference";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+// Discards cout while alive, for structures that report every update on it
+struct QuietOutput {
+    std::streambuf* saved;
+    QuietOutput() : saved(std::cout.rdbuf(nullptr)) {}
+    ~QuietOutput() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+};
+
+// Space-separated list, or "none"
+inline std::string joinAnswer(const std::vector<std::string>& items) {
+    std::string answer;
+    for (const std::string& item : items) answer += (answer.empty() ? "" : " ") + item;
+    return answer.empty() ? "none" : answer;
+}
+
+#endif
@@ -2,20 +2,259 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <iterator>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+
+#include "slot_schedule.h"
+#include "slot_state_log.h"
+#include "trace_harness.h"
+
 using namespace std;
 
 // Trie Node structure
 struct TrieNode {
     unordered_map<string, TrieNode*> children;
     bool isAvailable; // Indicates if a slot is available (true = available, false = occupied)
+    string label; // Name of this level (station, slot, ...)
+    vector<TrieNode*> childList; // Children in insertion order, for stable policy scans
+    int childIndex; // Position in the parent's childList
+    unique_ptr<SlotScheduleIndex> childSchedules; // Bookings of the children by childIndex, once any are made
+    bool isSlot; // Added as a slot (the end of an addSlot hierarchy)
+    int totalSlots; // Slots in this subtree
+    int freeSlots; // Available slots in this subtree
+    size_t nextChild; // Round-robin cursor into childList
+    bool hasPosition; // x/y set (stations), used by the nearest policy
+    double x, y;
+
+    TrieNode(const string& label = "")
+        : isAvailable(true), label(label), childIndex(0), isSlot(false), totalSlots(0), freeSlots(0),
+          nextChild(0), hasPosition(false), x(0), y(0) {}
+};
 
-    TrieNode() : isAvailable(true) {}
+// How allocateBest picks among the children that still have free slots
+enum class AllocationPolicy {
+    LeastLoaded, // Highest fraction of free slots
+    Nearest,     // Closest to the caller among children with a position
+    RoundRobin   // Rotate through children
 };
 
 // Trie class for EV Charging Management
 class EVChargingTrie {
 private:
     TrieNode* root;
+    mutex scheduleLock; // Guards bookings and the child lists reservations walk
+    mutex allocationLock; // Makes check-and-claim of slot availability atomic
+    SlotStateLog* journal = nullptr; // Durable log of slot changes, once attached
+    uint64_t loggedSeq = 0; // Journal sequence of the last change
+    static constexpr size_t kCheckpointInterval = 10000;
+
+    // Nodes from the root along a hierarchy (root first), or empty if it does not exist
+    vector<TrieNode*> pathTo(const vector<string>& locationHierarchy) const {
+        vector<TrieNode*> path{root};
+        for (const string& location : locationHierarchy) {
+            auto it = path.back()->children.find(location);
+            if (it == path.back()->children.end()) return {};
+            path.push_back(it->second);
+        }
+        return path;
+    }
+
+    static void adjustCounts(const vector<TrieNode*>& path, int total, int free) {
+        for (TrieNode* node : path) {
+            node->totalSlots += total;
+            node->freeSlots += free;
+        }
+    }
+
+    // Set the last node's availability, keeping the free counts on its path
+    // in step. Returns false if it already had that availability.
+    static bool setAvailability(const vector<TrieNode*>& path, bool available) {
+        TrieNode* node = path.back();
+        if (node->isAvailable == available) return false;
+        node->isAvailable = available;
+        if (node->isSlot) adjustCounts(path, 0, available ? 1 : -1);
+        return true;
+    }
+
+    // Create any missing nodes along a hierarchy; returns them root first
+    vector<TrieNode*> createPath(const vector<string>& locationHierarchy) {
+        vector<TrieNode*> path{root};
+        for (const string& location : locationHierarchy) {
+            TrieNode* currentNode = path.back();
+            if (!currentNode->children.count(location)) {
+                TrieNode* child = new TrieNode(location);
+                lock_guard<mutex> lock(scheduleLock);
+                child->childIndex = (int)currentNode->childList.size();
+                currentNode->children[location] = child;
+                currentNode->childList.push_back(child);
+                if (currentNode->childSchedules) currentNode->childSchedules->addSlot(child->childIndex);
+            }
+            path.push_back(currentNode->children[location]);
+        }
+        return path;
+    }
+
+    // Bookings of node's children, created on first use with every existing
+    // child registered. Caller holds scheduleLock.
+    static SlotScheduleIndex& childSchedules(TrieNode* node) {
+        if (!node->childSchedules) {
+            node->childSchedules.reset(new SlotScheduleIndex());
+            node->childSchedules->addSlots(0, (int)node->childList.size() - 1);
+        }
+        return *node->childSchedules;
+    }
+
+    // Create the nodes along a hierarchy and mark the last one as a slot;
+    // returns true if the slot is new
+    bool insertPath(const vector<string>& locationHierarchy) {
+        vector<TrieNode*> path = createPath(locationHierarchy);
+        TrieNode* slotNode = path.back();
+        if (slotNode == root || slotNode->isSlot) return false;
+        slotNode->isSlot = true;
+        adjustCounts(path, 1, slotNode->isAvailable ? 1 : 0);
+        return true;
+    }
+
+    // Child of node to descend into for allocateBest, or nullptr if none has a free slot
+    static TrieNode* chooseChild(TrieNode* node, AllocationPolicy policy, double x, double y) {
+        const vector<TrieNode*>& children = node->childList;
+        if (policy == AllocationPolicy::RoundRobin) {
+            for (size_t step = 0; step < children.size(); step++) {
+                size_t index = (node->nextChild + step) % children.size();
+                if (children[index]->freeSlots > 0) {
+                    node->nextChild = index + 1;
+                    return children[index];
+                }
+            }
+            return nullptr;
+        }
+
+        TrieNode* best = nullptr;
+        if (policy == AllocationPolicy::Nearest) {
+            double bestDistance = 0;
+            for (TrieNode* child : children) {
+                if (child->freeSlots == 0 || !child->hasPosition) continue;
+                double distance = hypot(child->x - x, child->y - y);
+                if (!best || distance < bestDistance) {
+                    best = child;
+                    bestDistance = distance;
+                }
+            }
+            if (best) return best;
+            // No positioned child at this level: fall back to least loaded
+        }
+        for (TrieNode* child : children) {
+            if (child->freeSlots == 0) continue;
+            // Compare free fractions without division
+            long long lhs = (long long)child->freeSlots * (best ? best->totalSlots : 1);
+            long long rhs = best ? (long long)best->freeSlots * child->totalSlots : 0;
+            if (!best || lhs > rhs || (lhs == rhs && child->freeSlots > best->freeSlots)) best = child;
+        }
+        return best;
+    }
+
+    // Record: op byte, then each hierarchy level as a 32-bit length and its bytes
+    static void appendPath(string& out, const vector<string>& locationHierarchy) {
+        for (const string& location : locationHierarchy) {
+            uint32_t length = (uint32_t)location.size();
+            out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out += location;
+        }
+    }
+
+    static vector<string> readPath(const string& bytes, size_t begin, size_t end) {
+        vector<string> locationHierarchy;
+        while (end - begin >= sizeof(uint32_t)) {
+            uint32_t length;
+            memcpy(&length, bytes.data() + begin, sizeof(length));
+            begin += sizeof(length);
+            if (length > end - begin) break;
+            locationHierarchy.push_back(bytes.substr(begin, length));
+            begin += length;
+        }
+        return locationHierarchy;
+    }
+
+    // Queue a change that has already been applied on the journal ('A' add,
+    // 'O' occupy, 'F' free; see waitDurable). Only appends, so holding
+    // allocationLock (which the caller does) never waits on the disk.
+    void logChange(char op, const vector<string>& locationHierarchy) {
+        if (!journal) return;
+        string record(1, op);
+        appendPath(record, locationHierarchy);
+        loggedSeq = journal->append(record);
+    }
+
+    // Re-apply a journaled change during recovery
+    void replayChange(const string& record) {
+        if (record.empty()) return;
+        vector<string> locationHierarchy = readPath(record, 1, record.size());
+        if (record[0] == 'A') {
+            insertPath(locationHierarchy);
+        } else {
+            vector<TrieNode*> path = pathTo(locationHierarchy);
+            if (!path.empty()) setAvailability(path, record[0] == 'F');
+        }
+    }
+
+    // Every slot and every occupied node, each as a 32-bit entry size, a
+    // state byte (bit 0 available, bit 1 slot) and its path
+    string snapshot() const {
+        struct Frame {
+            const TrieNode* node;
+            unordered_map<string, TrieNode*>::const_iterator next;
+        };
+        string bytes;
+        vector<string> path;
+        vector<Frame> frames{{root, root->children.begin()}};
+        while (!frames.empty()) {
+            Frame& top = frames.back();
+            if (top.next == top.node->children.end()) {
+                frames.pop_back();
+                if (!path.empty()) path.pop_back();
+                continue;
+            }
+            const TrieNode* node = top.next->second;
+            path.push_back(top.next->first);
+            ++top.next;
+            if (node->isSlot || !node->isAvailable) {
+                string entry(1, (char)((node->isAvailable ? 1 : 0) | (node->isSlot ? 2 : 0)));
+                appendPath(entry, path);
+                uint32_t size = (uint32_t)entry.size();
+                bytes.append(reinterpret_cast<const char*>(&size), sizeof(size));
+                bytes += entry;
+            }
+            frames.push_back({node, node->children.begin()});
+        }
+        return bytes;
+    }
+
+    void restore(const string& bytes) {
+        size_t pos = 0;
+        while (bytes.size() - pos >= sizeof(uint32_t)) {
+            uint32_t size;
+            memcpy(&size, bytes.data() + pos, sizeof(size));
+            pos += sizeof(size);
+            if (size == 0 || size > bytes.size() - pos) break;
+            vector<string> locationHierarchy = readPath(bytes, pos + 1, pos + size);
+            vector<TrieNode*> path = createPath(locationHierarchy);
+            if (bytes[pos] & 2) insertPath(locationHierarchy);
+            setAvailability(path, (bytes[pos] & 1) != 0);
+            pos += size;
+        }
+    }
 
 public:
     // Constructor
@@ -25,23 +264,21 @@ public:
 
     // Add a new charging slot to the trie
     void addSlot(const vector<string>& locationHierarchy) {
-        TrieNode* currentNode = root;
-        for (const string& location : locationHierarchy) {
-            if (!currentNode->children.count(location)) {
-                currentNode->children[location] = new TrieNode();
-            }
-            currentNode = currentNode->children[location];
+        {
+            lock_guard<mutex> lock(allocationLock);
+            if (insertPath(locationHierarchy)) logChange('A', locationHierarchy);
         }
         cout << "Charging slot added successfully.\n";
     }
 
     // Allocate a slot if available
     void allocateSlot(const vector<string>& locationHierarchy) {
-        TrieNode* slotNode = navigateToSlot(locationHierarchy);
-        if (slotNode && slotNode->isAvailable) {
-            slotNode->isAvailable = false;
+        lock_guard<mutex> lock(allocationLock);
+        vector<TrieNode*> path = pathTo(locationHierarchy);
+        if (!path.empty() && setAvailability(path, false)) {
+            logChange('O', locationHierarchy);
             cout << "Slot allocated successfully.\n";
-        } else if (!slotNode) {
+        } else if (path.empty()) {
             cout << "Error: Slot does not exist.\n";
         } else {
             cout << "Error: Slot already occupied.\n";
@@ -50,20 +287,88 @@ public:
 
     // Free a slot
     void freeSlot(const vector<string>& locationHierarchy) {
-        TrieNode* slotNode = navigateToSlot(locationHierarchy);
-        if (slotNode && !slotNode->isAvailable) {
-            slotNode->isAvailable = true;
+        lock_guard<mutex> lock(allocationLock);
+        vector<TrieNode*> path = pathTo(locationHierarchy);
+        if (!path.empty() && setAvailability(path, true)) {
+            logChange('F', locationHierarchy);
             cout << "Slot freed successfully.\n";
-        } else if (!slotNode) {
+        } else if (path.empty()) {
             cout << "Error: Slot does not exist.\n";
         } else {
             cout << "Error: Slot is already free.\n";
         }
     }
 
+    // Claim a free slot anywhere under region (e.g. {"Vayujiva"} or
+    // {"Vayujiva", station}), descending by the subtree free counts and
+    // choosing among children by policy. (x, y) is the caller's position for
+    // the Nearest policy. Returns the claimed slot's hierarchy, or an empty
+    // vector if nothing under region is free.
+    vector<string> allocateBest(const vector<string>& region, AllocationPolicy policy,
+                                double x = 0, double y = 0) {
+        lock_guard<mutex> lock(allocationLock);
+        vector<TrieNode*> path = pathTo(region);
+        if (path.empty() || path.back()->freeSlots == 0) return {};
+        while (!(path.back()->isSlot && path.back()->isAvailable)) {
+            TrieNode* next = chooseChild(path.back(), policy, x, y);
+            if (!next) return {};
+            path.push_back(next);
+        }
+        setAvailability(path, false);
+
+        vector<string> locationHierarchy;
+        for (size_t i = 1; i < path.size(); i++) locationHierarchy.push_back(path[i]->label);
+        logChange('O', locationHierarchy);
+        return locationHierarchy;
+    }
+
+    // Record where a station is, for the Nearest policy
+    bool setStationPosition(const string& stationName, double x, double y) {
+        lock_guard<mutex> lock(allocationLock);
+        TrieNode* stationNode = navigateToStation(stationName);
+        if (!stationNode) return false;
+        stationNode->hasPosition = true;
+        stationNode->x = x;
+        stationNode->y = y;
+        return true;
+    }
+
+    // Recover the slots from the journal at basePath, then log every later
+    // change to it. Returns false if the journal cannot be opened.
+    bool attachJournal(SlotStateLog& log, const string& basePath) {
+        bool opened = log.open(basePath,
+                               [this](const string& bytes) { restore(bytes); },
+                               [this](const string& record) { replayChange(record); });
+        if (opened) journal = &log;
+        return opened;
+    }
+
+    // Block until every change journaled so far, by any thread, is on disk.
+    // Changes are only queued when made, under allocationLock; callers wait
+    // here afterwards without the lock, so concurrent allocations share a
+    // flush. Every kCheckpointInterval records the log is compacted, which
+    // needs a consistent snapshot and so briefly holds allocationLock.
+    // Returns false if the journal has failed and changes were lost (they
+    // stay applied in memory).
+    bool waitDurable() {
+        if (!journal) return true;
+        uint64_t seq;
+        {
+            lock_guard<mutex> lock(allocationLock);
+            seq = loggedSeq;
+            if (journal->recordsSinceCheckpoint() >= kCheckpointInterval) journal->checkpoint(snapshot());
+        }
+        return journal->waitDurable(seq);
+    }
+
+    // Number of available slots at a station, or -1 if it does not exist
+    int availableSlots(const string& stationName) {
+        return countAvailableSlots("Vayujiva", stationName, root);
+    }
+
     // Check availability of a specific station
     void checkSlotAvailability(const string& stationName) {
-        int availableSlots = countAvailableSlots("Vayujiva", stationName, root);
+        int availableSlots = this->availableSlots(stationName);
         if (availableSlots >= 0) {
             cout << "Available slots at " << stationName << ": " << availableSlots << endl;
         } else {
@@ -71,7 +376,56 @@ public:
         }
     }
 
+    // Book a specific slot for [start, end); fails if it does not exist or overlaps a booking
+    bool reserveSlot(const vector<string>& locationHierarchy, long long start, long long end) {
+        lock_guard<mutex> lock(scheduleLock);
+        vector<TrieNode*> path = pathTo(locationHierarchy);
+        if (path.size() < 2) return false;
+        return childSchedules(path[path.size() - 2]).book(path.back()->childIndex, start, end);
+    }
+
+    // Book any slot at the station that is free for [start, end) in one step.
+    // The best fit wins: the slot whose free gap around the window starts
+    // latest, the one added first on ties. Returns the slot name, or an
+    // empty string if none is free. O(log g) for g free gaps at the station.
+    string reserveAnySlot(const string& stationName, long long start, long long end) {
+        lock_guard<mutex> lock(scheduleLock);
+        TrieNode* stationNode = navigateToStation(stationName);
+        if (!stationNode) return "";
+        int index;
+        if (!childSchedules(stationNode).bookAny(start, end, index)) return "";
+        return stationNode->childList[index]->label;
+    }
+
+    // Cancel the booking [start, end) on a specific slot
+    bool cancelReservation(const vector<string>& locationHierarchy, long long start, long long end) {
+        lock_guard<mutex> lock(scheduleLock);
+        vector<TrieNode*> path = pathTo(locationHierarchy);
+        if (path.size() < 2) return false;
+        return childSchedules(path[path.size() - 2]).cancel(path.back()->childIndex, start, end);
+    }
+
+    // Earliest start >= from of a session of the given length at the station.
+    // slotName receives the best-fit slot at that time (as for reserveAnySlot);
+    // it stays empty if the station has no slots.
+    long long earliestStart(const string& stationName, long long from, long long duration, string& slotName) {
+        slotName.clear();
+        lock_guard<mutex> lock(scheduleLock);
+        TrieNode* stationNode = navigateToStation(stationName);
+        if (!stationNode) return from;
+        int index;
+        long long start;
+        if (!childSchedules(stationNode).earliestStart(from, duration, start, index)) return from;
+        slotName = stationNode->childList[index]->label;
+        return start;
+    }
+
 private:
+    // Station node under the city, or nullptr
+    TrieNode* navigateToStation(const string& stationName) {
+        return navigateToSlot({"Vayujiva", stationName});
+    }
+
     // Navigate to a specific slot in the trie
     TrieNode* navigateToSlot(const vector<string>& locationHierarchy) {
         TrieNode* currentNode = root;
@@ -131,18 +485,371 @@ vector<string> getLocationHierarchy() {
     return hierarchy;
 }
 
+// Workload replay. A trace is a text file with one operation per line: an op
+// letter and its whitespace-separated arguments ('#' starts a comment line);
+// every station is in Vayujiva. --generate writes a random trace; --replay
+// runs a trace through a naive reference (flat station and slot lists) and
+// through EVChargingTrie, times both and reports the first answer that
+// differs.
+//
+//   A station slot             add slot
+//   O station slot             allocate slot       F station slot    free slot
+//   C station                  available slots (-1 if the station does not exist)
+//   W policy station|* x y     allocateBest; policy l(east loaded), n(earest) or r(ound robin)
+//   P station x y              set station position
+//   R station slot s e         reserve slot (-> 0/1)
+//   Y station s e              reserve any slot at station (-> slot)
+//   Z station slot s e         cancel reservation (-> 0/1)
+//   E station from len         earliest start (-> time slot)
+
+AllocationPolicy tracePolicy(const string& name) {
+    if (name == "n") return AllocationPolicy::Nearest;
+    if (name == "r") return AllocationPolicy::RoundRobin;
+    if (name == "l") return AllocationPolicy::LeastLoaded;
+    throw invalid_argument("unknown policy " + name);
+}
+
+// Reference for EVChargingTrie: stations and their slots in plain vectors in
+// the order they were added, searched linearly, with the same tie-breaking
+// rules the trie documents
+class ReferenceStations {
+private:
+    struct Slot {
+        string name;
+        bool isAvailable = true;
+        vector<pair<long long, long long>> bookings;
+    };
+
+    struct Station {
+        string name;
+        vector<Slot> slots;
+        bool hasPosition = false;
+        double x = 0, y = 0;
+        size_t nextSlot = 0;   // Round-robin cursor
+
+        int freeSlots() const {
+            int count = 0;
+            for (const Slot& slot : slots) count += slot.isAvailable;
+            return count;
+        }
+    };
+
+    vector<Station> stations;
+    size_t nextStation = 0;
+
+    Station* station(const string& name) {
+        for (Station& candidate : stations) {
+            if (candidate.name == name) return &candidate;
+        }
+        return nullptr;
+    }
+
+    Slot* slot(const string& stationName, const string& slotName) {
+        Station* owner = station(stationName);
+        if (!owner) return nullptr;
+        for (Slot& candidate : owner->slots) {
+            if (candidate.name == slotName) return &candidate;
+        }
+        return nullptr;
+    }
+
+    static bool windowFree(const Slot& slot, long long start, long long end) {
+        for (const auto& booking : slot.bookings) {
+            if (booking.first < end && start < booking.second) return false;
+        }
+        return true;
+    }
+
+    static long long earliestStart(const Slot& slot, long long from, long long duration) {
+        long long t = from;
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (const auto& booking : slot.bookings) {
+                if (booking.first < t + duration && t < booking.second) {
+                    t = booking.second;
+                    moved = true;
+                }
+            }
+        }
+        return t;
+    }
+
+    // Slot free for [start, end) whose gap before the window starts latest,
+    // first added on ties; a slot with no booking before it ranks last
+    static Slot* bestFit(Station& station, long long start, long long end) {
+        Slot* fit = nullptr;
+        long long fitGap = LLONG_MIN;
+        for (Slot& candidate : station.slots) {
+            if (!windowFree(candidate, start, end)) continue;
+            long long gapStart = LLONG_MIN;
+            for (const auto& booking : candidate.bookings) {
+                if (booking.second <= start) gapStart = max(gapStart, booking.second);
+            }
+            if (!fit || gapStart > fitGap) {
+                fit = &candidate;
+                fitGap = gapStart;
+            }
+        }
+        return fit;
+    }
+
+    // Index of the station allocateBest descends into from the city
+    int chooseStation(AllocationPolicy policy, double x, double y) {
+        if (policy == AllocationPolicy::RoundRobin) {
+            for (size_t step = 0; step < stations.size(); step++) {
+                size_t index = (nextStation + step) % stations.size();
+                if (stations[index].freeSlots() > 0) {
+                    nextStation = index + 1;
+                    return (int)index;
+                }
+            }
+            return -1;
+        }
+        int best = -1;
+        if (policy == AllocationPolicy::Nearest) {
+            double bestDistance = 0;
+            for (size_t i = 0; i < stations.size(); i++) {
+                if (stations[i].freeSlots() == 0 || !stations[i].hasPosition) continue;
+                double distance = hypot(stations[i].x - x, stations[i].y - y);
+                if (best == -1 || distance < bestDistance) {
+                    best = (int)i;
+                    bestDistance = distance;
+                }
+            }
+            if (best != -1) return best;
+        }
+        for (size_t i = 0; i < stations.size(); i++) {
+            int free = stations[i].freeSlots();
+            if (free == 0) continue;
+            if (best == -1) {
+                best = (int)i;
+                continue;
+            }
+            double ratio = (double)free / stations[i].slots.size();
+            double bestRatio = (double)stations[best].freeSlots() / stations[best].slots.size();
+            if (ratio > bestRatio || (ratio == bestRatio && free > stations[best].freeSlots())) best = (int)i;
+        }
+        return best;
+    }
+
+public:
+    string apply(const TraceOp& op) {
+        auto num = [&](size_t i) { return stoll(op.args.at(i)); };
+        switch (op.op) {
+        case 'A': {
+            Station* owner = station(op.args.at(0));
+            if (!owner) {
+                stations.push_back(Station());
+                owner = &stations.back();
+                owner->name = op.args[0];
+            }
+            if (!slot(op.args[0], op.args.at(1))) {
+                owner->slots.push_back(Slot());
+                owner->slots.back().name = op.args[1];
+            }
+            return "";
+        }
+        case 'O': case 'F':
+            if (Slot* target = slot(op.args.at(0), op.args.at(1))) target->isAvailable = op.op == 'F';
+            return "";
+        case 'C': {
+            Station* target = station(op.args.at(0));
+            return to_string(target ? target->freeSlots() : -1);
+        }
+        case 'W': {
+            AllocationPolicy policy = tracePolicy(op.args.at(0));
+            double x = stod(op.args.at(2)), y = stod(op.args.at(3));
+            Station* target = nullptr;
+            if (op.args[1] == "*") {
+                int index = chooseStation(policy, x, y);
+                if (index >= 0) target = &stations[index];
+            } else {
+                target = station(op.args[1]);
+            }
+            if (!target || target->freeSlots() == 0) return "none";
+            // Slots are alike under every policy except round robin: the first free one wins
+            size_t start = policy == AllocationPolicy::RoundRobin ? target->nextSlot : 0;
+            for (size_t step = 0; step < target->slots.size(); step++) {
+                size_t index = (start + step) % target->slots.size();
+                Slot& candidate = target->slots[index];
+                if (!candidate.isAvailable) continue;
+                if (policy == AllocationPolicy::RoundRobin) target->nextSlot = index + 1;
+                candidate.isAvailable = false;
+                return target->name + " " + candidate.name;
+            }
+            return "none";
+        }
+        case 'P': {
+            Station* target = station(op.args.at(0));
+            if (!target) return "0";
+            target->hasPosition = true;
+            target->x = stod(op.args.at(1));
+            target->y = stod(op.args.at(2));
+            return "1";
+        }
+        case 'R': {
+            Slot* target = slot(op.args.at(0), op.args.at(1));
+            if (!target || num(2) >= num(3) || !windowFree(*target, num(2), num(3))) return "0";
+            target->bookings.push_back({num(2), num(3)});
+            return "1";
+        }
+        case 'Y': {
+            Station* target = station(op.args.at(0));
+            if (!target || num(1) >= num(2)) return "none";
+            Slot* fit = bestFit(*target, num(1), num(2));
+            if (!fit) return "none";
+            fit->bookings.push_back({num(1), num(2)});
+            return fit->name;
+        }
+        case 'Z': {
+            Slot* target = slot(op.args.at(0), op.args.at(1));
+            if (!target) return "0";
+            auto match = find(target->bookings.begin(), target->bookings.end(), make_pair(num(2), num(3)));
+            if (match == target->bookings.end()) return "0";
+            target->bookings.erase(match);
+            return "1";
+        }
+        case 'E': {
+            Station* target = station(op.args.at(0));
+            if (!target || target->slots.empty()) return "none";
+            long long best = earliestStart(target->slots[0], num(1), num(2));
+            for (const Slot& candidate : target->slots) best = min(best, earliestStart(candidate, num(1), num(2)));
+            return to_string(best) + " " + bestFit(*target, best, best + num(2))->name;
+        }
+        }
+        return "";
+    }
+};
+
+// Answer one trace op with EVChargingTrie
+string applyToTrie(EVChargingTrie& trie, const TraceOp& op) {
+    auto num = [&](size_t i) { return stoll(op.args.at(i)); };
+    auto slotPath = [&]() { return vector<string>{"Vayujiva", op.args.at(0), op.args.at(1)}; };
+    switch (op.op) {
+    case 'A': trie.addSlot(slotPath()); return "";
+    case 'O': trie.allocateSlot(slotPath()); return "";
+    case 'F': trie.freeSlot(slotPath()); return "";
+    case 'C': return to_string(trie.availableSlots(op.args.at(0)));
+    case 'W': {
+        vector<string> region{"Vayujiva"};
+        if (op.args.at(1) != "*") region.push_back(op.args[1]);
+        vector<string> claimed = trie.allocateBest(region, tracePolicy(op.args.at(0)),
+                                                   stod(op.args.at(2)), stod(op.args.at(3)));
+        return claimed.size() == 3 ? claimed[1] + " " + claimed[2] : "none";
+    }
+    case 'P': return trie.setStationPosition(op.args.at(0), stod(op.args.at(1)), stod(op.args.at(2))) ? "1" : "0";
+    case 'R': return trie.reserveSlot(slotPath(), num(2), num(3)) ? "1" : "0";
+    case 'Y': {
+        string slotName = trie.reserveAnySlot(op.args.at(0), num(1), num(2));
+        return slotName.empty() ? "none" : slotName;
+    }
+    case 'Z': return trie.cancelReservation(slotPath(), num(2), num(3)) ? "1" : "0";
+    case 'E': {
+        string slotName;
+        long long start = trie.earliestStart(op.args.at(0), num(1), num(2), slotName);
+        return slotName.empty() ? "none" : to_string(start) + " " + slotName;
+    }
+    }
+    return "";
+}
+
+// Write a random trace of the given length over stations S0.. with slots L0..L7
+bool generateStationTrace(const string& path, long long operations, unsigned seed) {
+    ofstream out(path);
+    if (!out) return false;
+    mt19937 rng(seed);
+    int numStations = (int)max(8LL, operations / 200);
+    auto station = [&]() { return "S" + to_string(rng() % numStations); };
+    auto slotPath = [&]() { return station() + " L" + to_string(rng() % 8); };
+    auto point = [&]() { return to_string(rng() % 100) + " " + to_string(rng() % 100); };
+    auto window = [&]() {
+        long long start = rng() % 10000;
+        return to_string(start) + " " + to_string(start + 1 + rng() % 240);
+    };
+    const char* policies[] = {"l", "n", "r"};
+
+    out << "# EVChargingTrie trace, seed " << seed << "\n";
+    for (long long i = 0; i < operations; i++) {
+        switch (rng() % 20) {
+        case 0: case 1: case 2: case 3: out << "A " << slotPath() << "\n"; break;
+        case 4: case 5: out << "O " << slotPath() << "\n"; break;
+        case 6: case 7: case 8: out << "F " << slotPath() << "\n"; break;
+        case 9: out << "C " << station() << "\n"; break;
+        case 10: case 11:
+            out << "W " << policies[rng() % 3] << " " << (rng() % 4 ? "*" : station()) << " " << point() << "\n";
+            break;
+        case 12: out << "P " << station() << " " << point() << "\n"; break;
+        case 13: case 14: out << "R " << slotPath() << " " << window() << "\n"; break;
+        case 15: out << "Y " << station() << " " << window() << "\n"; break;
+        case 16: out << "Z " << slotPath() << " " << window() << "\n"; break;
+        default: out << "E " << station() << " " << rng() % 10000 << " " << 1 + rng() % 240 << "\n"; break;
+        }
+    }
+    return (bool)out;
+}
+
+// Replay a trace against the reference and EVChargingTrie; returns the exit code
+int replayStationTrace(const string& path) {
+    vector<TraceOp> trace;
+    if (!readTrace(path, trace)) {
+        cerr << "Cannot read trace " << path << ".\n";
+        return 1;
+    }
+    try {
+        vector<string> expected, answers;
+        ReferenceStations reference;
+        double seconds = runTrace(trace, expected, [&](const TraceOp& op) { return reference.apply(op); });
+        reportRun("reference", trace, seconds, expected, nullptr);
+
+        EVChargingTrie trie;
+        {
+            QuietOutput quiet;
+            seconds = runTrace(trace, answers, [&](const TraceOp& op) { return applyToTrie(trie, op); });
+        }
+        return reportRun("EVChargingTrie", trace, seconds, answers, &expected) ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Malformed trace " << path << ": " << e.what() << "\n";
+        return 1;
+    }
+}
+
 // Main function
-int main() {
+int main(int argc, char* argv[]) {
+    // Non-interactive modes:
+    //   --generate <trace> <operations> [seed]
+    //   --replay <trace>
+    if (argc >= 4 && string(argv[1]) == "--generate") {
+        if (!generateStationTrace(argv[2], atoll(argv[3]), argc >= 5 ? (unsigned)atoi(argv[4]) : 1)) {
+            cerr << "Cannot write trace " << argv[2] << ".\n";
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && string(argv[1]) == "--replay") {
+        return replayStationTrace(argv[2]);
+    }
+
     EVChargingTrie chargingTrie;
+    SlotStateLog journal;
     int choice;
 
+    if (!chargingTrie.attachJournal(journal, "ev_trie_slots")) {
+        cout << "Warning: slot journal unavailable; changes will not survive a restart.\n";
+    }
+
     while (true) {
         cout << "\nMenu:\n";
         cout << "1. Add Charging Slot\n";
         cout << "2. Allocate Charging Slot\n";
         cout << "3. Free Charging Slot\n";
         cout << "4. Check Available Slots in Station\n";
-        cout << "5. Exit\n";
+        cout << "5. Reserve Charging Slot for Time Window\n";
+        cout << "6. Reserve Any Slot in Station for Time Window\n";
+        cout << "7. Cancel Reservation\n";
+        cout << "8. Find Earliest Start in Station\n";
+        cout << "9. Allocate Best Slot\n";
+        cout << "10. Set Station Position\n";
+        cout << "11. Exit\n";
         cout << "Enter your choice: ";
         cin >> choice;
 
@@ -174,11 +881,117 @@ int main() {
             break;
 
         case 5:
+            {
+                locationHierarchy = getLocationHierarchy();
+                long long start, end;
+                cout << "Enter time window in minutes (start end): ";
+                cin >> start >> end;
+                if (chargingTrie.reserveSlot(locationHierarchy, start, end)) {
+                    cout << "Slot reserved successfully.\n";
+                } else {
+                    cout << "Error: Slot does not exist or is booked in that window.\n";
+                }
+            }
+            break;
+
+        case 6:
+            {
+                string stationName;
+                long long start, end;
+                cout << "Enter Station Name: ";
+                cin >> stationName;
+                cout << "Enter time window in minutes (start end): ";
+                cin >> start >> end;
+                string slotName = chargingTrie.reserveAnySlot(stationName, start, end);
+                if (slotName.empty()) {
+                    cout << "Error: No slot at " << stationName << " is free in that window.\n";
+                } else {
+                    cout << "Slot " << slotName << " reserved successfully.\n";
+                }
+            }
+            break;
+
+        case 7:
+            {
+                locationHierarchy = getLocationHierarchy();
+                long long start, end;
+                cout << "Enter reserved window in minutes (start end): ";
+                cin >> start >> end;
+                if (chargingTrie.cancelReservation(locationHierarchy, start, end)) {
+                    cout << "Reservation cancelled successfully.\n";
+                } else {
+                    cout << "Error: No such reservation.\n";
+                }
+            }
+            break;
+
+        case 8:
+            {
+                string stationName, slotName;
+                long long from, duration;
+                cout << "Enter Station Name: ";
+                cin >> stationName;
+                cout << "Enter earliest acceptable start and session length in minutes: ";
+                cin >> from >> duration;
+                long long start = chargingTrie.earliestStart(stationName, from, duration, slotName);
+                if (slotName.empty()) {
+                    cout << "Error: Station does not exist or has no slots.\n";
+                } else {
+                    cout << "Earliest start: " << start << " on slot " << slotName << endl;
+                }
+            }
+            break;
+
+        case 9:
+            {
+                string stationName;
+                int policyChoice;
+                double x = 0, y = 0;
+                cout << "Enter Station Name (* for any station): ";
+                cin >> stationName;
+                cout << "Policy (1 = least loaded, 2 = nearest, 3 = round robin): ";
+                cin >> policyChoice;
+                AllocationPolicy policy = policyChoice == 2 ? AllocationPolicy::Nearest
+                                        : policyChoice == 3 ? AllocationPolicy::RoundRobin
+                                        : AllocationPolicy::LeastLoaded;
+                if (policy == AllocationPolicy::Nearest) {
+                    cout << "Enter your position (x y): ";
+                    cin >> x >> y;
+                }
+                vector<string> region{"Vayujiva"};
+                if (stationName != "*") region.push_back(stationName);
+                locationHierarchy = chargingTrie.allocateBest(region, policy, x, y);
+                if (locationHierarchy.empty()) {
+                    cout << "Error: No free slot available.\n";
+                } else {
+                    cout << "Allocated slot " << locationHierarchy.back() << " at " << locationHierarchy[1] << endl;
+                }
+            }
+            break;
+
+        case 10:
+            {
+                string stationName;
+                double x, y;
+                cout << "Enter Station Name: ";
+                cin >> stationName;
+                cout << "Enter position (x y): ";
+                cin >> x >> y;
+                if (chargingTrie.setStationPosition(stationName, x, y)) {
+                    cout << "Station position updated.\n";
+                } else {
+                    cout << "Error: Station does not exist.\n";
+                }
+            }
+            break;
+
+        case 11:
             cout << "Goodbye! Exiting the system.\n";
             return 0;
 
         default:
             cout << "Invalid choice. Please enter a valid option.\n";
         }
+        if (!chargingTrie.waitDurable()) cout << "Error: the slot journal failed; changes are not being saved.\n";
     }
 }